@@ -2,24 +2,274 @@
 #include "../board.h"
 #include "../utils.h"
 #include "../search_engine.h"
+#include "../epd_reader.h"
+#include "../perft.h"
 #include <memory>
 #include <iostream>
+#include <stdio.h>
+#include <unistd.h>
 
 using ::wsun::cchess::cppupdate::Board;
 using ::wsun::cchess::cppupdate::SearchEngine;
 
+// 中局测试局面，不在开局库中
+static const char* MIDGAME_FEN = "r1ba1a3/4kn3/2n1b4/pNp1p1p1p/4c4/6P2/P1P2R2P/1CcC5/9/2BAKAB2 w";
+// 残局测试局面，双方只剩少量棋子
+static const char* ENDGAME_FEN = "2bak4/4a4/4b4/9/2p3n2/6P2/9/4B4/4A4/2RAK4 w";
+
+// 按fen串建一个棋盘，各个测试共用
+static std::unique_ptr<Board> make_board(const char* fen)
+{
+	std::unique_ptr<Board> b(new Board);
+	b->resetFromFen(fen);
+	return b;
+}
+
+// 不打印搜索信息的引擎
+static std::unique_ptr<SearchEngine> make_engine(Board* board)
+{
+	std::unique_ptr<SearchEngine> engine(new SearchEngine(board));
+	engine->setVerbose(false);
+	return engine;
+}
+
 void bench_func(benchmark::State& state)
 {
 	std::unique_ptr<Board> b(new Board);
 	std::unique_ptr<SearchEngine> engine(new SearchEngine(b.get()));
-	int mvs[MAX_GENERATE_MOVES];
 	for (auto _ : state)
 	{
-		b->generateAllMoves<::wsun::cchess::cppupdate::GENERAL>(mvs);
+		::wsun::cchess::cppupdate::MoveList list;
+		b->generateAllMoves<::wsun::cchess::cppupdate::GENERAL>(list);
 	}
 }
 
 BENCHMARK(bench_func);
 
-BENCHMARK_MAIN();
+// A/B对比：按棋子逐个通过函数指针间接调用生成函数(旧的分派方式)
+typedef void (*GenerateMovesFunc)(const ::wsun::cchess::cppupdate::Position&, int, ::wsun::cchess::cppupdate::MoveList&);
+
+static const GenerateMovesFunc indirect_generate_funcs[::wsun::cchess::cppupdate::PIECE_TYPE_NUMBER] = {
+	::wsun::cchess::cppupdate::generateMoves<::wsun::cchess::cppupdate::PIECE_TYPE_KING, ::wsun::cchess::cppupdate::GENERAL>,
+	::wsun::cchess::cppupdate::generateMoves<::wsun::cchess::cppupdate::PIECE_TYPE_ADVISOR, ::wsun::cchess::cppupdate::GENERAL>,
+	::wsun::cchess::cppupdate::generateMoves<::wsun::cchess::cppupdate::PIECE_TYPE_BISHOP, ::wsun::cchess::cppupdate::GENERAL>,
+	::wsun::cchess::cppupdate::generateMoves<::wsun::cchess::cppupdate::PIECE_TYPE_KNIGHT, ::wsun::cchess::cppupdate::GENERAL>,
+	::wsun::cchess::cppupdate::generateMoves<::wsun::cchess::cppupdate::PIECE_TYPE_ROOK, ::wsun::cchess::cppupdate::GENERAL>,
+	::wsun::cchess::cppupdate::generateMoves<::wsun::cchess::cppupdate::PIECE_TYPE_CANNON, ::wsun::cchess::cppupdate::GENERAL>,
+	::wsun::cchess::cppupdate::generateMoves<::wsun::cchess::cppupdate::PIECE_TYPE_PAWN, ::wsun::cchess::cppupdate::GENERAL>
+};
+
+void bench_generate_indirect(benchmark::State& state)
+{
+	std::unique_ptr<Board> b = make_board(MIDGAME_FEN);
+	const ::wsun::cchess::cppupdate::Position& position = b->position();
+	int side = b->currentSide();
+	for (auto _ : state)
+	{
+		::wsun::cchess::cppupdate::MoveList list;
+		int begin = ::wsun::cchess::cppupdate::side_tag(side);
+		for (int pc = begin; pc < begin + position.slotsNum(side); ++pc)
+		{
+			int pos = position.piecePos(pc);
+			if (pos)
+				indirect_generate_funcs[position.pieceType(pc)](position, pos, list);
+		}
+		benchmark::DoNotOptimize(list.size);
+	}
+}
+
+BENCHMARK(bench_generate_indirect);
+
+// A/B对比：按棋子类型分组，每种类型直接调用对应的生成函数
+void bench_generate_by_type(benchmark::State& state)
+{
+	std::unique_ptr<Board> b = make_board(MIDGAME_FEN);
+	for (auto _ : state)
+	{
+		::wsun::cchess::cppupdate::MoveList list;
+		::wsun::cchess::cppupdate::generateSideMoves<::wsun::cchess::cppupdate::GENERAL>(b->position(), b->currentSide(), list);
+		benchmark::DoNotOptimize(list.size);
+	}
+}
+
+BENCHMARK(bench_generate_by_type);
+
+// 中局的伪合法着法生成，车、炮的着法占了大部分
+void bench_midgame_moves(benchmark::State& state)
+{
+	std::unique_ptr<Board> b = make_board(MIDGAME_FEN);
+	for (auto _ : state)
+	{
+		::wsun::cchess::cppupdate::MoveList list;
+		benchmark::DoNotOptimize(b->generateAllMoves<::wsun::cchess::cppupdate::GENERAL>(list));
+		list.size = 0;
+		benchmark::DoNotOptimize(b->generateAllMoves<::wsun::cchess::cppupdate::CAPTURE>(list));
+	}
+}
+
+BENCHMARK(bench_midgame_moves);
+
+// 生成所有合法着法，主要开销在走完每步之后的将军检测
+void bench_legal_moves(benchmark::State& state)
+{
+	std::unique_ptr<Board> b = make_board(MIDGAME_FEN);
+	for (auto _ : state)
+	{
+		::wsun::cchess::cppupdate::MoveList list;
+		benchmark::DoNotOptimize(b->generateAllMovesNoncheck<::wsun::cchess::cppupdate::GENERAL>(list));
+	}
+}
+
+BENCHMARK(bench_legal_moves);
+
+// 残局的合法着法生成，只遍历棋盘上还在的棋子
+void bench_endgame_legal_moves(benchmark::State& state)
+{
+	std::unique_ptr<Board> b = make_board(ENDGAME_FEN);
+	for (auto _ : state)
+	{
+		::wsun::cchess::cppupdate::MoveList list;
+		benchmark::DoNotOptimize(b->generateAllMovesNoncheck<::wsun::cchess::cppupdate::GENERAL>(list));
+	}
+}
+
+BENCHMARK(bench_endgame_legal_moves);
+
+// fen串写到调用方的缓冲区再原地解析回来
+void bench_fen_roundtrip(benchmark::State& state)
+{
+	std::unique_ptr<Board> b = make_board(MIDGAME_FEN);
+	char buffer[::wsun::cchess::cppupdate::MAX_FEN_LENGTH];
+	for (auto _ : state)
+	{
+		int len = b->toFen(buffer, sizeof(buffer));
+		b->resetFromFen(buffer, buffer + len);
+	}
+}
+
+BENCHMARK(bench_fen_roundtrip);
+
+// 对局中每走一步就同步一次局面：增量同步只走新增的着法，完整同步每次都从fen串重放
+static const char* GAME_MOVES[] = { "h2e2", "h9g7", "h0g2", "i9h9", "i0h0", "b9c7", "b2c2", "c6c5", "c3c4", "b7a7" };
+
+void bench_sync_position(benchmark::State& state)
+{
+	std::unique_ptr<Board> b(new Board);
+	bool incremental = state.range(0) != 0;
+	for (auto _ : state)
+	{
+		char command[256] = "startpos moves";
+		b->reset();
+		for (const char* mv : GAME_MOVES)
+		{
+			strcat(command, " ");
+			strcat(command, mv);
+			if (!incremental)
+				b->reset();
+			benchmark::DoNotOptimize(b->syncPosition(command));
+		}
+	}
+}
+
+BENCHMARK(bench_sync_position)->Arg(0)->Arg(1);
+
+// 批量读取EPD文件，统计每秒解析的局面数
+void bench_epd_reader(benchmark::State& state)
+{
+	char path[] = "/tmp/bench_epd_XXXXXX";
+	int fd = mkstemp(path);
+	FILE* fp = fdopen(fd, "w");
+	for (int i = 0; i < state.range(0); ++i)
+		fprintf(fp, "%s bm h2e2;\n", (i & 1) ? MIDGAME_FEN : ENDGAME_FEN);
+	fclose(fp);
+
+	std::unique_ptr<Board> b(new Board);
+	::wsun::cchess::cppupdate::EpdReader reader(path);
+	int64_t positions = 0;
+	for (auto _ : state)
+	{
+		reader.rewind();
+		while (reader.next(*b))
+			++positions;
+	}
+	unlink(path);
+	state.counters["positions"] = benchmark::Counter(positions, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(bench_epd_reader)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+// 固定深度搜索，统计每秒搜索的节点数
+void bench_search_nps(benchmark::State& state)
+{
+	std::unique_ptr<Board> b(new Board);
+	std::unique_ptr<SearchEngine> engine = make_engine(b.get());
+	int64_t nodes = 0;
+	for (auto _ : state)
+	{
+		b->resetFromFen(MIDGAME_FEN);
+		benchmark::DoNotOptimize(engine->search(1 << 30, state.range(0)));
+		nodes += engine->allNodes();
+	}
+	state.counters["nps"] = benchmark::Counter(nodes, benchmark::Counter::kIsRate);
+}
 
+BENCHMARK(bench_search_nps)->Arg(6)->Unit(benchmark::kMillisecond);
+
+// Lazy SMP扩展性：固定深度的搜索时间(time-to-depth)和所有线程的节点数，参数为线程数
+void bench_search_threads(benchmark::State& state)
+{
+	std::unique_ptr<Board> b(new Board);
+	std::unique_ptr<SearchEngine> engine = make_engine(b.get());
+	engine->setThreads(state.range(0));
+	int64_t nodes = 0;
+	for (auto _ : state)
+	{
+		b->resetFromFen(MIDGAME_FEN);
+		benchmark::DoNotOptimize(engine->search(1 << 30, 7));
+		nodes += engine->allNodes();
+	}
+	state.counters["nps"] = benchmark::Counter(nodes, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(bench_search_threads)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)
+	->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// test_engine.cc的对局：引擎自己跟自己下，对比make/unmake与copy-make两种走棋方式，
+// 为了结果稳定从不在开局库中的中局开始，每步固定搜索深度而不是时间
+template <::wsun::cchess::cppupdate::MakeMovePolicy policy>
+void bench_engine_game(benchmark::State& state)
+{
+	std::unique_ptr<Board> b(new Board);
+	std::unique_ptr<SearchEngine> engine = make_engine(b.get());
+	int64_t nodes = 0;
+	for (auto _ : state)
+	{
+		b->resetFromFen(MIDGAME_FEN);
+		for (int ply = 0; ply < 16 && !b->noWayToMove(); ++ply)
+		{
+			int mv = engine->search<policy>(1 << 30, state.range(0));
+			nodes += engine->allNodes();
+			if (mv <= 0)
+				break;
+			b->play(::wsun::cchess::cppupdate::Move(mv));
+		}
+	}
+	state.counters["nps"] = benchmark::Counter(nodes, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK_TEMPLATE(bench_engine_game, ::wsun::cchess::cppupdate::MAKE_UNMAKE)->Arg(5)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(bench_engine_game, ::wsun::cchess::cppupdate::COPY_MAKE)->Arg(5)->Unit(benchmark::kMillisecond);
+
+// 走法生成吞吐量：中局局面的perft，最后一层只数走法个数，不用置换表
+void bench_perft(benchmark::State& state)
+{
+	std::unique_ptr<Board> b = make_board(MIDGAME_FEN);
+	int64_t nodes = 0;
+	for (auto _ : state)
+		nodes += ::wsun::cchess::cppupdate::perft(*b, state.range(0));
+	state.counters["nps"] = benchmark::Counter(nodes, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(bench_perft)->Arg(3)->Arg(4)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
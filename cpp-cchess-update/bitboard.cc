@@ -0,0 +1,239 @@
+#include "bitboard.h"
+
+namespace wsun
+{
+namespace cchess
+{
+namespace cppupdate
+{
+
+namespace
+{
+
+constexpr int table_pos(int row, int col)
+{
+	return ((row + 3) << 4) + (col + 3);
+}
+
+constexpr bool table_in_board(int row, int col)
+{
+	return row >= 0 && row < BOARD_ROWS && col >= 0 && col < BOARD_COLS;
+}
+
+constexpr bool table_in_fort(int row, int col)
+{
+	return table_in_board(row, col) && col >= 3 && col <= 5 && (row <= 2 || row >= 7);
+}
+
+constexpr int table_sq(int row, int col)
+{
+	return table_in_board(row, col) ? row * BOARD_COLS + col : -1;
+}
+
+// 在长度为len的一行(列)上，从idx出发，计算车能到达的位置和炮能吃到的位置
+constexpr void slide_masks(int len, int idx, int occ, uint16_t& rook, uint16_t& cannon)
+{
+	rook = 0;
+	cannon = 0;
+	for (int step = -1; step <= 1; step += 2)
+	{
+		int i = idx + step;
+		while (i >= 0 && i < len && !(occ & (1 << i)))
+		{
+			rook |= (uint16_t)(1 << i);
+			i += step;
+		}
+		if (i < 0 || i >= len) continue;
+		rook |= (uint16_t)(1 << i);
+		i += step;
+		while (i >= 0 && i < len && !(occ & (1 << i)))
+			i += step;
+		if (i >= 0 && i < len)
+			cannon |= (uint16_t)(1 << i);
+	}
+}
+
+constexpr BitboardTables make_bitboard_tables()
+{
+	BitboardTables t {};
+	const int kingDelta[4][2] = { {-1, 0}, {0, -1}, {0, 1}, {1, 0} };
+	const int advisorDelta[4][2] = { {-1, -1}, {-1, 1}, {1, -1}, {1, 1} };
+
+	for (int pos = 0; pos < 256; ++pos)
+		t.posToSq[pos] = -1;
+	for (int sq = 0; sq < BOARD_SQUARES; ++sq)
+	{
+		int row = sq / BOARD_COLS;
+		int col = sq % BOARD_COLS;
+		t.sqRow[sq] = (uint8_t)row;
+		t.sqCol[sq] = (uint8_t)col;
+		t.sqToPos[sq] = (uint8_t)table_pos(row, col);
+		t.posToSq[table_pos(row, col)] = (int16_t)sq;
+	}
+
+	for (int idx = 0; idx < BOARD_COLS; ++idx)
+		for (int occ = 0; occ < (1 << BOARD_COLS); ++occ)
+			slide_masks(BOARD_COLS, idx, occ, t.rookRank[idx][occ], t.cannonRank[idx][occ]);
+	for (int idx = 0; idx < BOARD_ROWS; ++idx)
+		for (int occ = 0; occ < (1 << BOARD_ROWS); ++occ)
+			slide_masks(BOARD_ROWS, idx, occ, t.rookFile[idx][occ], t.cannonFile[idx][occ]);
+	for (int mask = 0; mask < (1 << BOARD_ROWS); ++mask)
+	{
+		Bitboard b = 0;
+		for (int row = 0; row < BOARD_ROWS; ++row)
+			if (mask & (1 << row))
+				b |= (Bitboard)1 << (row * BOARD_COLS);
+		t.fileSpread[mask] = b;
+	}
+
+	for (int sq = 0; sq < BOARD_SQUARES; ++sq)
+	{
+		int row = sq / BOARD_COLS;
+		int col = sq % BOARD_COLS;
+		bool redHalf = row >= 5;
+
+		for (int i = 0; i < 4; ++i)
+		{
+			// 马：马腿在正交方向，目标在马腿外侧的两个斜向
+			int legRow = row + kingDelta[i][0];
+			int legCol = col + kingDelta[i][1];
+			t.knightLeg[sq][i] = (int8_t)table_sq(legRow, legCol);
+			t.knightTo[sq][i] = 0;
+			for (int j = -1; j <= 1; j += 2)
+			{
+				int toRow = legRow + kingDelta[i][0] + (kingDelta[i][0] == 0 ? j : 0);
+				int toCol = legCol + kingDelta[i][1] + (kingDelta[i][1] == 0 ? j : 0);
+				if (table_in_board(toRow, toCol))
+					t.knightTo[sq][i] |= (Bitboard)1 << table_sq(toRow, toCol);
+			}
+
+			// 反向马：攻击sq的马的马腿在sq的斜向
+			int checkLegRow = row + advisorDelta[i][0];
+			int checkLegCol = col + advisorDelta[i][1];
+			t.knightCheckLeg[sq][i] = (int8_t)table_sq(checkLegRow, checkLegCol);
+			t.knightFrom[sq][i] = 0;
+			if (table_in_board(checkLegRow, checkLegCol))
+			{
+				int fromRow1 = checkLegRow + advisorDelta[i][0];
+				int fromCol2 = checkLegCol + advisorDelta[i][1];
+				if (table_in_board(fromRow1, checkLegCol))
+					t.knightFrom[sq][i] |= (Bitboard)1 << table_sq(fromRow1, checkLegCol);
+				if (table_in_board(checkLegRow, fromCol2))
+					t.knightFrom[sq][i] |= (Bitboard)1 << table_sq(checkLegRow, fromCol2);
+			}
+
+			// 象：不能过河
+			int eyeRow = row + advisorDelta[i][0];
+			int eyeCol = col + advisorDelta[i][1];
+			int toRow = eyeRow + advisorDelta[i][0];
+			int toCol = eyeCol + advisorDelta[i][1];
+			t.bishopEye[sq][i] = -1;
+			t.bishopTo[sq][i] = 0;
+			if (table_in_board(toRow, toCol) && (toRow >= 5) == redHalf)
+			{
+				t.bishopEye[sq][i] = (int8_t)table_sq(eyeRow, eyeCol);
+				t.bishopTo[sq][i] = (Bitboard)1 << table_sq(toRow, toCol);
+			}
+
+			// 士、将(帅)：只在九宫内
+			if (table_in_fort(row, col) &&
+					table_in_fort(row + advisorDelta[i][0], col + advisorDelta[i][1]))
+				t.advisorTo[sq] |= (Bitboard)1 << table_sq(row + advisorDelta[i][0], col + advisorDelta[i][1]);
+			if (table_in_fort(row, col) &&
+					table_in_fort(row + kingDelta[i][0], col + kingDelta[i][1]))
+				t.kingTo[sq] |= (Bitboard)1 << table_sq(row + kingDelta[i][0], col + kingDelta[i][1]);
+		}
+
+		// 兵(卒)：红方向上，黑方向下，过河后可以左右走
+		for (int side = 0; side < 2; ++side)
+		{
+			int forward = side == 0 ? -1 : 1;
+			bool crossed = side == 0 ? row <= 4 : row >= 5;
+			if (table_in_board(row + forward, col))
+				t.pawnTo[side][sq] |= (Bitboard)1 << table_sq(row + forward, col);
+			if (table_in_board(row - forward, col))
+				t.pawnFrom[side][sq] |= (Bitboard)1 << table_sq(row - forward, col);
+			if (crossed)
+			{
+				for (int j = -1; j <= 1; j += 2)
+				{
+					if (table_in_board(row, col + j))
+					{
+						t.pawnTo[side][sq] |= (Bitboard)1 << table_sq(row, col + j);
+						t.pawnFrom[side][sq] |= (Bitboard)1 << table_sq(row, col + j);
+					}
+				}
+			}
+		}
+	}
+	return t;
+}
+
+} // namespace
+
+constexpr BitboardTables bitboard_tables = make_bitboard_tables();
+
+Bitboard BitboardSet::moveTargets(int side, int type, int sq) const
+{
+	switch (type)
+	{
+		case PIECE_TYPE_KING:
+			return bitboard_tables.kingTo[sq];
+		case PIECE_TYPE_ADVISOR:
+			return bitboard_tables.advisorTo[sq];
+		case PIECE_TYPE_BISHOP:
+			return bishopAttacks(sq);
+		case PIECE_TYPE_KNIGHT:
+			return knightAttacks(sq);
+		case PIECE_TYPE_ROOK:
+			return rookAttacks(sq);
+		case PIECE_TYPE_CANNON:
+			return (rookAttacks(sq) & ~occupied_) | cannonAttacks(sq);
+		case PIECE_TYPE_PAWN:
+			return bitboard_tables.pawnTo[side][sq];
+		default:
+			return 0;
+	}
+}
+
+bool BitboardSet::attacked(int sq, int bySide) const
+{
+	const BitboardTables& t = bitboard_tables;
+	Bitboard by = sides_[bySide];
+
+	// 车以及将帅照面
+	if (rookAttacks(sq) & by & (types_[PIECE_TYPE_ROOK] | types_[PIECE_TYPE_KING]))
+		return true;
+	if (cannonAttacks(sq) & by & types_[PIECE_TYPE_CANNON])
+		return true;
+
+	Bitboard knights = by & types_[PIECE_TYPE_KNIGHT];
+	for (int i = 0; i < 4; ++i)
+	{
+		int leg = t.knightCheckLeg[sq][i];
+		if (leg >= 0 && !(occupied_ & square_bb(leg)) && (t.knightFrom[sq][i] & knights))
+			return true;
+	}
+
+	return (t.pawnFrom[bySide][sq] & by & types_[PIECE_TYPE_PAWN]) != 0;
+}
+
+template <MoveGenerateType mgt>
+Bitboard BitboardSet::generateTargets(int side, int type, int pos) const
+{
+	int sq = pos_to_sq(pos);
+	if (type == PIECE_TYPE_CANNON)
+	{
+		Bitboard targets = cannonAttacks(sq) & sides_[1 - side];
+		if (mgt == GENERAL)
+			targets |= rookAttacks(sq) & ~occupied_;
+		return targets;
+	}
+	return moveTargets(side, type, sq) & (mgt == GENERAL ? ~sides_[side] : sides_[1 - side]);
+}
+template Bitboard BitboardSet::generateTargets<GENERAL>(int side, int type, int pos) const;
+template Bitboard BitboardSet::generateTargets<CAPTURE>(int side, int type, int pos) const;
+
+} // namespace cppupdate
+} // namespace cchess
+} // namespace wsun
@@ -0,0 +1,185 @@
+#ifndef __WSUN_CCHESS_CPP_UPDATE_BITBOARD_H__
+#define __WSUN_CCHESS_CPP_UPDATE_BITBOARD_H__
+
+#include <inttypes.h>
+#include "utils.h"
+
+namespace wsun
+{
+namespace cchess
+{
+namespace cppupdate
+{
+
+// 位棋盘：棋盘上90个交叉点各占一位（sq = row * 9 + col），用128位整数存放
+typedef unsigned __int128 Bitboard;
+
+static const int BOARD_ROWS = 10;
+static const int BOARD_COLS = 9;
+static const int BOARD_SQUARES = 90;
+
+// 位棋盘所需的预计算表，全部在编译期生成
+struct BitboardTables
+{
+	int16_t posToSq[256];								// 16x16棋盘位置 -> 90格编号，不在棋盘上为-1
+	uint8_t sqToPos[BOARD_SQUARES];			// 90格编号 -> 16x16棋盘位置
+	uint8_t sqRow[BOARD_SQUARES];
+	uint8_t sqCol[BOARD_SQUARES];
+
+	// 行、列上的滑动着法，以(所在行/列中的位置, 该行/列的占位)为索引
+	uint16_t rookRank[BOARD_COLS][1 << BOARD_COLS];			// 车能到达的位置（含第一个阻挡子）
+	uint16_t cannonRank[BOARD_COLS][1 << BOARD_COLS];		// 炮隔子能吃到的位置
+	uint16_t rookFile[BOARD_ROWS][1 << BOARD_ROWS];
+	uint16_t cannonFile[BOARD_ROWS][1 << BOARD_ROWS];
+	Bitboard fileSpread[1 << BOARD_ROWS];								// 列占位 -> 第0列上的位棋盘
+
+	int8_t knightLeg[BOARD_SQUARES][4];					// 马腿位置
+	Bitboard knightTo[BOARD_SQUARES][4];				// 马腿未被蹩时能到达的位置
+	int8_t knightCheckLeg[BOARD_SQUARES][4];		// 反向马腿：攻击该格的马所用的马腿
+	Bitboard knightFrom[BOARD_SQUARES][4];			// 经过对应马腿能攻击该格的马的位置
+	int8_t bishopEye[BOARD_SQUARES][4];					// 象眼位置
+	Bitboard bishopTo[BOARD_SQUARES][4];
+	Bitboard advisorTo[BOARD_SQUARES];
+	Bitboard kingTo[BOARD_SQUARES];
+	Bitboard pawnTo[2][BOARD_SQUARES];					// 某方的兵(卒)能走到的位置
+	Bitboard pawnFrom[2][BOARD_SQUARES];				// 能攻击该格的某方兵(卒)的位置
+};
+
+extern const BitboardTables bitboard_tables;
+
+inline static Bitboard square_bb(int sq)
+{
+	return (Bitboard)1 << sq;
+}
+
+inline static int pos_to_sq(int pos)
+{
+	return bitboard_tables.posToSq[pos];
+}
+
+inline static int sq_to_pos(int sq)
+{
+	return bitboard_tables.sqToPos[sq];
+}
+
+// 最低位的格子编号（b不能为0）
+inline static int lsb(Bitboard b)
+{
+	uint64_t lo = (uint64_t)b;
+	return lo ? __builtin_ctzll(lo) : 64 + __builtin_ctzll((uint64_t)(b >> 64));
+}
+
+inline static int pop_lsb(Bitboard& b)
+{
+	int sq = lsb(b);
+	b &= b - 1;
+	return sq;
+}
+
+inline static int popcount(Bitboard b)
+{
+	return __builtin_popcountll((uint64_t)b) + __builtin_popcountll((uint64_t)(b >> 64));
+}
+
+// 按红黑方、棋子类型分别存放的位棋盘集合
+// 另外维护一份按列优先编号(col * 10 + row)的占位，用于快速取出一列的占位
+class BitboardSet
+{
+public:
+	BitboardSet() { reset(); }
+
+	void reset()
+	{
+		sides_[0] = sides_[1] = 0;
+		for (int i = 0; i < PIECE_TYPE_NUMBER; ++i)
+			types_[i] = 0;
+		occupied_ = occupiedFile_ = 0;
+	}
+
+	// 在pos处放上或拿走一个棋子
+	void toggle(int side, int type, int pos)
+	{
+		int sq = pos_to_sq(pos);
+		Bitboard b = square_bb(sq);
+		sides_[side] ^= b;
+		types_[type] ^= b;
+		occupied_ ^= b;
+		occupiedFile_ ^= square_bb(bitboard_tables.sqCol[sq] * BOARD_ROWS + bitboard_tables.sqRow[sq]);
+	}
+
+	Bitboard pieces(int side, int type) const { return sides_[side] & types_[type]; }
+	Bitboard sidePieces(int side) const { return sides_[side]; }
+	Bitboard occupied() const { return occupied_; }
+
+	// 车在sq处沿行列能到达的位置（含第一个阻挡子，不分红黑）
+	Bitboard rookAttacks(int sq) const
+	{
+		const BitboardTables& t = bitboard_tables;
+		int row = t.sqRow[sq];
+		int col = t.sqCol[sq];
+		unsigned rankOcc = (unsigned)(occupied_ >> (row * BOARD_COLS)) & 0x1ff;
+		unsigned fileOcc = (unsigned)(occupiedFile_ >> (col * BOARD_ROWS)) & 0x3ff;
+		return ((Bitboard)t.rookRank[col][rankOcc] << (row * BOARD_COLS)) |
+					 (t.fileSpread[t.rookFile[row][fileOcc]] << col);
+	}
+
+	// 炮在sq处隔一子能吃到的位置（不分红黑）
+	Bitboard cannonAttacks(int sq) const
+	{
+		const BitboardTables& t = bitboard_tables;
+		int row = t.sqRow[sq];
+		int col = t.sqCol[sq];
+		unsigned rankOcc = (unsigned)(occupied_ >> (row * BOARD_COLS)) & 0x1ff;
+		unsigned fileOcc = (unsigned)(occupiedFile_ >> (col * BOARD_ROWS)) & 0x3ff;
+		return ((Bitboard)t.cannonRank[col][rankOcc] << (row * BOARD_COLS)) |
+					 (t.fileSpread[t.cannonFile[row][fileOcc]] << col);
+	}
+
+	Bitboard knightAttacks(int sq) const
+	{
+		const BitboardTables& t = bitboard_tables;
+		Bitboard att = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			int leg = t.knightLeg[sq][i];
+			if (leg < 0 || !(occupied_ & square_bb(leg)))
+				att |= t.knightTo[sq][i];
+		}
+		return att;
+	}
+
+	Bitboard bishopAttacks(int sq) const
+	{
+		const BitboardTables& t = bitboard_tables;
+		Bitboard att = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			int eye = t.bishopEye[sq][i];
+			if (eye >= 0 && !(occupied_ & square_bb(eye)))
+				att |= t.bishopTo[sq][i];
+		}
+		return att;
+	}
+
+	// 某个棋子在sq处一步所能到达的所有位置(吃子或不吃子)
+	Bitboard moveTargets(int side, int type, int sq) const;
+
+	// 某方是否有棋子攻击到sq(包括将帅照面)
+	bool attacked(int sq, int bySide) const;
+
+	// 某棋子所有着法的目标位置
+	template <MoveGenerateType mgt>
+	Bitboard generateTargets(int side, int type, int pos) const;
+
+private:
+	Bitboard sides_[2];
+	Bitboard types_[PIECE_TYPE_NUMBER];
+	Bitboard occupied_;
+	Bitboard occupiedFile_;
+};
+
+} // namespace cppupdate
+} // namespace cchess
+} // namespace wsun
+
+#endif
@@ -26,38 +26,6 @@ static PieceType get_piece_type(char c)
 	return PIECE_TYPE_NONE;
 }
 
-struct step* step_create()
-{
-	struct step* step = (struct step*)malloc(sizeof(struct step));
-	memset(step, 0, sizeof(struct step));
-	return step;
-}
-void step_release(struct step* step)
-{
-	free(step);
-}
-
-void Board::initHistoryStepRecords()
-{
-	history_step_records_capacity = INIT_HISTORY_STEPS_RECORD_SIZE;
-	history_step_records = 
-		(struct step**)malloc(sizeof(struct step*) * history_step_records_capacity);
-	for (int i = 0; i < history_step_records_capacity; ++i)
-	{
-		history_step_records[i] = step_create();
-	}
-	history_step_records_size = 0;
-}
-
-void Board::releaseHistoryStepRecords()
-{
-	for (int i = 0; i < history_step_records_capacity; ++i)
-	{
-		step_release(history_step_records[i]);
-	}
-	free(history_step_records);
-}
-
 Board* Board::getExchangeSideBoard() const
 {
 	Board* b = new Board;
@@ -65,14 +33,14 @@ Board* Board::getExchangeSideBoard() const
 	for (int i = 0; i < 256; ++i)
 	{
 		if (!in_board(i)) continue;
-		Piece* p = pieces_[i];
-		if (p && p->show())
+		int pc = position_->pieceAt(i);
+		if (pc)
 		{
-			b->addPieceToBoard(p->type(), SideType(1 - (int)(p->sidePlayer()->side())), 254 - p->pos());
+			b->addPieceToBoard(position_->pieceType(pc), SideType(1 - side_of_piece(pc)), 254 - i);
 		}
 	}
-	b->currentSidePlayer_ = 
-		(currentSidePlayer_->side() == SIDE_TYPE_RED ? b->blackPlayer_ : b->redPlayer_);
+	if (currentSide() == SIDE_TYPE_RED)
+		b->changeSide();
 
 	return b;
 }
@@ -84,85 +52,104 @@ Board* Board::getMirrorBoard() const
 	for (int i = 0; i < 256; ++i)
 	{
 		if (!in_board(i)) continue;
-		Piece* p = pieces_[i];
-		if (p && p->show())
+		int pc = position_->pieceAt(i);
+		if (pc)
 		{
-			b->addPieceToBoard(p->type(), p->sidePlayer()->side(), mirror_pos(p->pos()));
+			b->addPieceToBoard(position_->pieceType(pc), SideType(side_of_piece(pc)), mirror_pos(i));
 		}
 	}
-	b->currentSidePlayer_ = 
-		(currentSidePlayer_->side() == SIDE_TYPE_RED ? b->redPlayer_ : b->blackPlayer_);
+	if (currentSide() == SIDE_TYPE_BLACK)
+		b->changeSide();
 
 	return b;
 }
 
-Zobrist Board::getMirrorZobrist() const
-{
-	ZobristHelper zh;
-	for (int i = 0; i < 256; ++i)
-	{
-		if (!in_board(i)) continue;
-		Piece* piece = pieces_[i];
-		if (piece && piece->show())
-			zh.updateByChangePiece(piece->sidePlayer()->side(), 
-														 piece->type(), 
-														 mirror_pos(piece->pos()));
-	}
-	SideType side = currentSidePlayer_->side();
-	if (side == SIDE_TYPE_BLACK)
-	{
-		zh.updateByChangeSide();
-	}
-	return zh.getZobrist();
-}
-
 void Board::addPieceToBoard(PieceType type, SideType side, int pos)
 {
-	Player* sidePlayer = 
-		(side == SIDE_TYPE_RED ? redPlayer_ : blackPlayer_);
-	Piece* piece = new Piece(type, sidePlayer, pos);
-	pieces_[pos] = piece;
-	sidePlayer->addPiece(piece);
-	zobristHelper_.updateByChangePiece(side, type, pos);
+	position_->addNewPiece(side, type, pos);
 }
 
 void Board::resetData()
 {
+	startFenLength_ = 0;
 	accumStepsFromCapture_ = 0;
 	turnNums_ = 1;
 
-	redPlayer_->reset();
-	blackPlayer_->reset();
-	currentSidePlayer_ = redPlayer_;
-	initPieceArray();
-	history_step_records_size = 0;
-	zobristHelper_.reset();
+	position_ = positions_.data();
+	position_->clear();
+	historyStepsSize_ = 0;
+}
+
+void Board::copyFrom(const Board& other)
+{
+	size_t top = other.position_ - other.positions_.data();
+	if (positions_.size() < other.positions_.size())
+		positions_.resize(other.positions_.size());
+	std::copy(other.positions_.begin(), other.positions_.begin() + top + 1, positions_.begin());
+	position_ = positions_.data() + top;
+	memcpy(startFen_, other.startFen_, sizeof(startFen_));
+	startFenLength_ = other.startFenLength_;
+
+	if (historySteps_.size() < other.historySteps_.size())
+		historySteps_.resize(other.historySteps_.size());
+	std::copy(other.historySteps_.begin(), other.historySteps_.begin() + other.historyStepsSize_,
+			historySteps_.begin());
+	historyStepsSize_ = other.historyStepsSize_;
+	accumStepsFromCapture_ = other.accumStepsFromCapture_;
+	turnNums_ = other.turnNums_;
+}
+
+// fen串中局面和下棋方部分的结束位置，之后的计数和EPD操作不影响局面
+static const char* fen_position_end(const char* fen, const char* end)
+{
+	const char* p = fen;
+	while (p < end && !isspace((unsigned char)*p))
+		++p;
+	const char* board = p;
+	while (p < end && (*p == ' ' || *p == '\t'))
+		++p;
+	return (p < end && isalpha(*p)) ? p + 1 : board;
+}
+
+// 十进制输出非负整数，返回写入之后的位置
+static char* write_number(char* p, int number)
+{
+	char digits[12];
+	int n = 0;
+	do
+	{
+		digits[n++] = (char)('0' + number % 10);
+		number /= 10;
+	} while (number > 0);
+	while (n > 0)
+	{
+		*p++ = digits[--n];
+	}
+	return p;
 }
 
-// 用fen串信息来初始化局面
-int Board::initFromFen(const char* fen)
+// 用[fen, end)范围内的fen串信息来初始化局面
+const char* Board::initFromFen(const char* fen, const char* end, SideType& side)
 {
 	int row = 0;
 	int col = 0;
 
-	int i = 0;
-	while (!isspace(fen[i]))
+	const char* p = fen;
+	for (; p < end && !isspace((unsigned char)*p); ++p)
 	{
-		char c = fen[i];
+		char c = *p;
 		if (isdigit(c))
 		{
 			col += (int)(c - '0');
 		}
 		else if (isalpha(c))
 		{
-			SideType side = SIDE_TYPE_RED;
-			if (islower(c))
-			{
-				side = SIDE_TYPE_BLACK;
-			}
+			SideType pieceSide = islower(c) ? SIDE_TYPE_BLACK : SIDE_TYPE_RED;
 			PieceType type = get_piece_type(toupper(c));
 
-			addPieceToBoard(type, side, convert_to_pos(row, col));
+			// 超出棋盘的棋子直接忽略，避免错误的fen串写坏局面
+			if (type != PIECE_TYPE_NONE && row < 10 && col < 9)
+				addPieceToBoard(type, pieceSide, convert_to_pos(row, col));
 			++col;
 		}
 		else if (c == '/')
@@ -170,542 +157,429 @@ int Board::initFromFen(const char* fen)
 			++row;
 			col = 0;
 		}
-		++i;
 	}
 
-	if (fen[++i] == 'b')
-		return SIDE_TYPE_BLACK;
-	else
-		return SIDE_TYPE_RED;
+	// 下棋方与局面之间只跳过同一行内的空白
+	while (p < end && (*p == ' ' || *p == '\t'))
+		++p;
+
+	side = SIDE_TYPE_RED;
+	if (p < end && isalpha(*p))
+	{
+		if (*p == 'b')
+			side = SIDE_TYPE_BLACK;
+		++p;
+	}
+	return p;
 }
 
-// 根据fen串信息重置局面
-void Board::resetFromFen(const char* fen)
+// 根据[fen, end)范围内的fen串信息原地重置局面
+const char* Board::resetFromFen(const char* fen, const char* end)
 {
 	resetData();
 
-	int side = initFromFen(fen);
-	currentSidePlayer_ = 
-		(side == SIDE_TYPE_RED ? redPlayer_ : blackPlayer_);
-
+	SideType side;
+	const char* p = initFromFen(fen, end, side);
 	if (side == SIDE_TYPE_BLACK)
 	{
-		zobristHelper_.updateByChangeSide();
+		position_->changeSide();
+	}
+
+	// 记录起始局面，用于之后的增量同步
+	int length = (int)(fen_position_end(fen, p) - fen);
+	if (length < MAX_FEN_LENGTH)
+	{
+		memcpy(startFen_, fen, length);
+		startFenLength_ = length;
 	}
+	return p;
 }
 
-// 重置到最初局面
-void Board::reset()
+bool Board::sameStartFen(const char* fen, const char* end) const
 {
-	resetData();
-	initFromFen(INIT_FEN_STRING);
+	int length = (int)(fen_position_end(fen, end) - fen);
+	return startFenLength_ > 0 && length == startFenLength_ &&
+		memcmp(startFen_, fen, length) == 0;
 }
 
-// 根据当前局面输出fen格式的局面信息
-std::string Board::toFen()
+int Board::syncMoves(int index, const Move* moves, int count)
 {
-	char fenBuffer[100] = {0};
-	char* fen = fenBuffer;
-	for (int row = 0; row < 10; ++row)
+	for (int i = index; i < count; ++i)
 	{
-		int number = 0;
-		for (int col = 0; col < 9; ++col)
-		{
-			int pos = convert_to_pos(row, col);
-			if (pieces_[pos] && pieces_[pos]->show())
-			{
-				if (number > 0)
-				{
-					*fen = (char)('0' + number);
-					++fen;
-					number = 0;
-				}
-				int side = pieces_[pos]->sidePlayer()->side();
-				*fen = fen_piece_char[side][pieces_[pos]->type()];
-				++fen;
-			}
-			else 
-			{
-				++number;
-			}
-		}
-		if (number > 0)
-		{
-			*fen = (char)('0' + number);
-			++fen;
-		}
-
-		*fen = '/';
-		++fen;
+		if (!legalMove(moves[i]))
+			break;
+		play(moves[i]);
 	}
-
-	--fen;
-	*fen = ' ';
-	++fen;
-	*fen = (currentSidePlayer_->side() == SIDE_TYPE_RED ? 'w' : 'b');
-	sprintf(fen+1, " - - %d %d", accumStepsFromCapture_, (turnNums_ + 1) / 2);
-
-	return std::string(fenBuffer);
+	return historyStepsSize_;
 }
 
-bool Board::willKillKing(Player* player)
+int Board::syncPosition(const char* fen, const Move* moves, int count)
 {
-	Player* oppPlayer = getOpponentPlayerByPlayer(player);
-	Piece** pieces = oppPlayer->pieces();
-	Piece* kingPiece = player->kingPiece();
-
-	for (int i = 0; i < oppPlayer->piecesNum(); ++i)
+	const char* end = fen + strlen(fen);
+	if (sameStartFen(fen, end) && historyStepsSize_ <= count)
 	{
-		if (pieces[i]->show() && pieces[i]->legalMove(pieces_, kingPiece->pos()))
-		{
-			return true;
-		}
+		int i = 0;
+		while (i < historyStepsSize_ && historySteps_[i].mv == moves[i])
+			++i;
+		if (i == historyStepsSize_)
+			return syncMoves(i, moves, count);
 	}
-	return false;
+
+	resetFromFen(fen, end);
+	return syncMoves(0, moves, count);
 }
 
-// 生成某棋子所有的走法(注意：不存在走完之后依然被对方将军),
-// capatured: 是否只生成吃子走法
-int Board::generateMoves(Piece* piece, int* mvs, bool capatured)
+// 下一个以空白分隔的单词，返回单词开始位置，wordEnd为单词结束位置
+static const char* next_word(const char* p, const char*& wordEnd)
 {
-	// 必须保证棋子在棋盘上
-	if (!piece || !piece->show()) return 0;
+	while (*p && isspace((unsigned char)*p))
+		++p;
+	wordEnd = p;
+	while (*wordEnd && !isspace((unsigned char)*wordEnd))
+		++wordEnd;
+	return p;
+}
 
-	int nums = 0;
-	if (piece->type() == PIECE_TYPE_KING)
-	{
-		// 九宫内的走法
-		for (int i = 0; i < 4; ++i)
-		{
-			int dest = piece->pos() + array_king_delta[i];
-			if (!in_fort(dest)) continue;
+static bool word_equal(const char* word, const char* wordEnd, const char* str)
+{
+	int length = (int)strlen(str);
+	return wordEnd - word == length && memcmp(word, str, length) == 0;
+}
 
-			if (!capatured)
-			{
-				if (!pieces_[dest])
-				{
-					mvs[nums++] = get_move(piece->pos(), dest);
-				}
-			}
-			
-			if (piece->oppSide(pieces_[dest]))
-			{
-				mvs[nums++] = get_move(piece->pos(), dest);
-			}
-		}
+int Board::syncPosition(const char* command)
+{
+	const char* wordEnd;
+	const char* word = next_word(command, wordEnd);
+	const char* fen;
+	const char* fenEnd;
+	const char* rest;
+	if (word_equal(word, wordEnd, "startpos"))
+	{
+		fen = INIT_FEN_STRING;
+		fenEnd = fen + strlen(fen);
+		rest = wordEnd;
 	}
-	else if (piece->type() == PIECE_TYPE_ADVISOR)
+	else if (word_equal(word, wordEnd, "fen"))
 	{
-		for (int i = 0; i < 4; ++i)
-		{
-			int dest = piece->pos() + array_advisor_delta[i];
-			if (!in_fort(dest)) continue;
-
-			if (!capatured)
-			{
-				if (!pieces_[dest])
-				{
-					mvs[nums++] = get_move(piece->pos(), dest);
-				}
-			}
-			
-			if (piece->oppSide(pieces_[dest]))
-			{
-				mvs[nums++] = get_move(piece->pos(), dest);
-			}
-		}
+		fen = next_word(wordEnd, fenEnd);
+		// fen串之后可能还有计数，一直到moves为止
+		const char* moves = strstr(fen, " moves");
+		fenEnd = moves ? moves : fen + strlen(fen);
+		rest = fenEnd;
 	}
-	else if (piece->type() == PIECE_TYPE_BISHOP)
+	else
 	{
-		for (int i = 0; i < 4; ++i)
-		{
-			int dest = piece->pos() + array_advisor_delta[i];
+		return -1;
+	}
 
-			if (!in_board(dest) || 
-					!same_half(piece->pos(), dest) || 
-					pieces_[dest])
-			{
-				continue;
-			}
+	// 定位到第一个着法
+	const char* mv = rest;
+	word = next_word(rest, wordEnd);
+	if (word_equal(word, wordEnd, "moves"))
+		mv = wordEnd;
 
-			dest += array_advisor_delta[i];
-			if (!capatured)
-			{
-				if (!pieces_[dest])
-				{
-					mvs[nums++] = get_move(piece->pos(), dest);
-				}
-			}
-			
-			if (piece->oppSide(pieces_[dest]))
-			{
-				mvs[nums++] = get_move(piece->pos(), dest);
-			}
-		}
+	// 已走的着法与历史表逐个比较，一旦不同就完整重置
+	const char* p = mv;
+	bool synced = sameStartFen(fen, fenEnd);
+	for (int i = 0; synced && i < historyStepsSize_; ++i)
+	{
+		word = next_word(p, wordEnd);
+		synced = wordEnd - word == 4 &&
+			historySteps_[i].mv == Move(iccs_move_to_move(word));
+		p = wordEnd;
 	}
-	else if (piece->type() == PIECE_TYPE_KNIGHT)
+	if (!synced)
 	{
-		for (int i = 0; i < 4; ++i)
-		{
-			int dest = piece->pos() + array_king_delta[i];
-			if (pieces_[dest]) continue;
-
-			for (int j = 0; j < 2; ++j)
-			{
-				dest = piece->pos() + array_knight_delta[i][j];
-				if (!in_board(dest)) continue;
-
-				if (!capatured)
-				{
-					if (!pieces_[dest])
-					{
-						mvs[nums++] = get_move(piece->pos(), dest);
-					}
-				}
-				
-				if (piece->oppSide(pieces_[dest]))
-				{
-					mvs[nums++] = get_move(piece->pos(), dest);
-				}
-			}
-		}
+		resetFromFen(fen, fenEnd);
+		p = mv;
 	}
-	else if (piece->type() == PIECE_TYPE_ROOK)
+
+	for (;;)
 	{
-		for (int i = 0; i < 4; ++i)
-		{
-			int nDelta = array_king_delta[i];
-			int dest = piece->pos() + nDelta;
-			while (in_board(dest))
-			{
-				if (pieces_[dest])
-				{
-					if (piece->oppSide(pieces_[dest]))
-					{
-						mvs[nums++] = get_move(piece->pos(), dest);
-					}
-					break;
-				}
-				if (!capatured)
-				{
-					mvs[nums++] = get_move(piece->pos(), dest);
-				}
-				dest += nDelta;
-			}
-		}
+		word = next_word(p, wordEnd);
+		if (wordEnd - word != 4)
+			break;
+		Move move(iccs_move_to_move(word));
+		if (!legalMove(move))
+			break;
+		play(move);
+		p = wordEnd;
 	}
-	else if (piece->type() == PIECE_TYPE_CANNON)
+	return historyStepsSize_;
+}
+
+// 重置到最初局面
+void Board::reset()
+{
+	resetFromFen(INIT_FEN_STRING);
+}
+
+// 根据当前局面输出fen格式的局面信息
+int Board::toFen(char* buffer, int size) const
+{
+	// 棋盘最多99个字符，加上下棋方和两个计数也不会超过MAX_FEN_LENGTH
+	if (size < MAX_FEN_LENGTH)
+		return 0;
+
+	char* fen = buffer;
+	for (int row = 0; row < 10; ++row)
 	{
-		for (int i = 0; i < 4; ++i)
+		int number = 0;
+		for (int col = 0; col < 9; ++col)
 		{
-			int nDelta = array_king_delta[i];
-			int dest = piece->pos() + nDelta;
-			while (in_board(dest))
+			int pos = convert_to_pos(row, col);
+			int pc = position_->pieceAt(pos);
+			if (pc)
 			{
-				if (!pieces_[dest])
+				if (number > 0)
 				{
-					if (!capatured)
-					{
-						mvs[nums++] = get_move(piece->pos(), dest);
-					}
+					*fen++ = (char)('0' + number);
+					number = 0;
 				}
-				else break;
-
-				dest += nDelta;
+				*fen++ = fen_piece_char[side_of_piece(pc)][position_->pieceType(pc)];
 			}
-			dest += nDelta;
-			while (in_board(dest))
+			else 
 			{
-				if (!pieces_[dest]) dest += nDelta;
-				else
-				{
-					if (piece->oppSide(pieces_[dest]))
-					{
-						mvs[nums++] = get_move(piece->pos(), dest);
-					}
-					break;
-				}
+				++number;
 			}
 		}
-	}
-	else if (piece->type() == PIECE_TYPE_PAWN)
-	{
-		int dest = piece->forwardStep();
-		if (in_board(dest))
+		if (number > 0)
 		{
-			// capatured move
-			if (piece->oppSide(pieces_[dest]))
-			{
-				mvs[nums++] = get_move(piece->pos(), dest);
-			}
-
-			if (!capatured && !pieces_[dest])
-			{
-				mvs[nums++] = get_move(piece->pos(), dest);
-			}
+			*fen++ = (char)('0' + number);
 		}
+		*fen++ = '/';
+	}
 
-		// 过河兵
-		if (!same_half(piece->sidePlayer()->kingPiece()->pos(), piece->pos()))
-		{
-			for (int nDelta = -1; nDelta <= 1; nDelta += 2)
-			{
-				dest = piece->pos() + nDelta;
-
-				if (!in_board(dest)) continue;
+	fen[-1] = ' ';
+	*fen++ = (currentSide() == SIDE_TYPE_RED ? 'w' : 'b');
+	memcpy(fen, " - - ", 5);
+	fen += 5;
+	fen = write_number(fen, accumStepsFromCapture_);
+	*fen++ = ' ';
+	fen = write_number(fen, (turnNums_ + 1) / 2);
+	*fen = '\0';
 
-				// capatured move
-				if (piece->oppSide(pieces_[dest]))
-				{
-					mvs[nums++] = get_move(piece->pos(), dest);
-				}
+	return (int)(fen - buffer);
+}
 
-				if (!capatured && !pieces_[dest])
-				{
-					mvs[nums++] = get_move(piece->pos(), dest);
-				}
-			}
-		}
-	}
-	return nums;
+bool Board::willKillKing(SideType side)
+{
+	int kingPos = position_->kingPos(side);
+	// 帅(将)已被吃掉(只会出现在伪合法着法中)
+	if (!kingPos) return false;
+#if defined(CCHESS_ATTACK_MAPS)
+	return position_->attacked(kingPos, 1 - side);
+#elif defined(CCHESS_BITBOARD_BACKEND)
+	return position_->bitboards().attacked(pos_to_sq(kingPos), 1 - side);
+#else
+	return position_->checked(side);
+#endif
 }
 
-// 生成所有棋子所有的走法 capatured: 是否只生成吃子走法
-template <MoveGenerateType mgt>
-int Board::generateAllMovesNoncheck(int* mvs)
+bool Board::movedIntoCheck()
 {
-	int nums = 0;
-	int n = 0;
-	int temp[MAX_GENERATE_MOVES];
-	Piece** pieces = currentSidePlayer_->pieces();
-  int size = currentSidePlayer_->piecesNum();
-	for (int i = 0; i < size; ++i)
-	{
-    // printf("player pieces: %d, %d", currentSidePlayer_->piecesNum(), currentSidePlayer_->side());
-    // if (pieces[i]) printf(", %s\n", pieces[i]->cname());
-    // else printf("\n");
-		n += pieces[i]->generateMvs<mgt>(pieces_, &temp[n]);
-	}
-	for (int i = 0; i < n; ++i)
+#ifdef CCHESS_ATTACK_MAPS
+	// 攻击表已随走棋更新，直接查表
+	return willKillKing(currentSide());
+#else
+	const struct step& step = historySteps_[historyStepsSize_ - 1];
+	int start = step.mv.start();
+	int end = step.mv.end();
+	SideType side = currentSide();
+
+	// 走之前就被将军或者走的是帅(将)，只能完整检查一遍
+	if (historyStepsSize_ < 2 ||
+			historySteps_[historyStepsSize_ - 2].in_check ||
+			position_->typeAt(end) == PIECE_TYPE_KING)
 	{
-		makeMove(temp[i]);
-		if (!willKillSelfKing())
-		{
-			mvs[nums++] = temp[i];
-		}
-		undoMove();
+		return willKillKing(side);
 	}
-
-	return nums;
+	return position_->exposedByMove(side, start, end);
+#endif
 }
-template int Board::generateAllMovesNoncheck<GENERAL>(int *mvs);
-template int Board::generateAllMovesNoncheck<CAPTURE>(int *mvs);
 
-template <MoveGenerateType mgt>
-int Board::generateAllMoves(int* mvs)
+// 生成pos处棋子所有的走法并追加到list(注意：可能存在走完之后依然被对方将军的走法),
+// capatured: 是否只生成吃子走法
+int Board::generateMoves(int pos, MoveList& list, bool capatured)
 {
-	int nums = 0;
-	Piece** pieces = currentSidePlayer_->pieces();
-  int size = currentSidePlayer_->piecesNum();
-	for (int i = 0; i < size; ++i)
+	// 必须保证棋子在棋盘上
+	if (position_->pieceAt(pos))
 	{
-    // printf("player pieces: %d, %d", currentSidePlayer_->piecesNum(), currentSidePlayer_->side());
-    // if (pieces[i]) printf(", %s\n", pieces[i]->cname());
-    // else printf("\n");
-		nums += pieces[i]->generateMvs<mgt>(pieces_, &mvs[nums]);
+		if (capatured)
+			generatePieceMoves<CAPTURE>(pos, list);
+		else
+			generatePieceMoves<GENERAL>(pos, list);
 	}
-	return nums;
-}
-template int Board::generateAllMoves<GENERAL>(int *mvs);
-template int Board::generateAllMoves<CAPTURE>(int *mvs);
-
-void Board::addPiece(Piece* piece, int pos)
-{
-	if (!piece) return ;
-	piece->setShow(true);
-	piece->setPos(pos);
-	pieces_[pos] = piece;
-	piece->sidePlayer()->addPieceValue(piece);
-
-	int side = piece->sidePlayer()->side();
-	zobristHelper_.updateByChangePiece(side, piece->type(), pos);
+	return list.size;
 }
 
-Piece* Board::delPiece(int pos)
+// 生成所有棋子所有的走法 capatured: 是否只生成吃子走法
+template <MoveGenerateType mgt>
+int Board::generateAllMovesNoncheck(MoveList& list)
 {
-	Piece* piece = pieces_[pos];
-	if (!piece) return NULL;
-
-	piece->setShow(false);
-	piece->sidePlayer()->delPieceValue(piece);
-	pieces_[pos] = NULL;
-
-	int side = piece->sidePlayer()->side();
-	zobristHelper_.updateByChangePiece(side, piece->type(), pos);
-
-	return piece;
+	generateAllMoves<mgt>(list);
+	return filterLegalMoves(list);
 }
+template int Board::generateAllMovesNoncheck<GENERAL>(MoveList& list);
+template int Board::generateAllMovesNoncheck<CAPTURE>(MoveList& list);
+
+int Board::filterLegalMoves(MoveList& list)
+{
+	SideType side = currentSide();
+	int kingPos = position_->kingPos(side);
+	if (!kingPos)
+		return list.size;
+
+	// 被将军时只有解将着法才需要检查，否则只检查帅(将)、被牵制的棋子以及可能成为炮架的走法
+	CheckInfo info;
+	uint32_t pinned = 0;
+	bool checked = inCheck();
+	if (checked)
+		position_->checkInfo(side, info);
+	else
+		pinned = position_->pinnedMask(side);
 
-bool Board::legalMovePiece1(Piece* piece, int dest)
-{
-	if (piece->type() == PIECE_TYPE_KING)
-	{
-		// 判断在九宫的走法是否合理
-		if(in_fort(dest) && array_legal_span[dest - piece->pos() + 256] == 1)
-			return 1;
-	}
-
-	if (piece->type() == PIECE_TYPE_ADVISOR)
-	{
-		return in_fort(dest) && array_legal_span[dest - piece->pos() + 256] == 2;
-	}
-	else if (piece->type() == PIECE_TYPE_BISHOP)
-	{
-		return same_half(piece->pos(), dest) &&
-					 array_legal_span[dest - piece->pos() + 256] == 3 &&
-					 !pieces_[((piece->pos() + dest) >> 1)];
-	}
-	else if (piece->type() == PIECE_TYPE_KNIGHT)
-	{
-		return piece->pos() != piece->pos() + array_knight_pin[dest - piece->pos() + 256] && 
-					 !pieces_[(piece->pos() + array_knight_pin[dest - piece->pos() + 256])];
-	}
-	else if (piece->type() == PIECE_TYPE_KING || piece->type() == PIECE_TYPE_ROOK || piece->type() == PIECE_TYPE_CANNON)
+	int nums = 0;
+	for (int i = 0; i < list.size; ++i)
 	{
-		int offset = get_offset(piece->pos(), dest);
-		if (offset == 0)
-		{
-			return 0;
-		}
-		else
+		int start = list.moves[i].move.start();
+		int end = list.moves[i].move.end();
+		int pc = position_->pieceAt(start);
+		bool verify = true;
+		if (start != kingPos)
 		{
-			int curPos = piece->pos() + offset;
-			while (curPos != dest && !pieces_[curPos])
-			{
-				curPos += offset;
-			}
-			if (curPos == dest)
+			if (checked)
 			{
-				if (piece->type() == PIECE_TYPE_KING)
-				{
-					return pieces_[dest] && pieces_[dest]->type() == PIECE_TYPE_KING;
-				}
-				else if (piece->type() == PIECE_TYPE_ROOK)
-				{
-					return !piece->sameSide(pieces_[dest]);
-				}
-				else
-				{
-					return !pieces_[dest];
-				}
+				if (!info.mayEvade(kingPos, start, end))
+					continue;
 			}
-			else
+			else if (!(pinned & (1u << (pc - 16))) && !get_offset(kingPos, end))
 			{
-				if (piece->type() == PIECE_TYPE_KING || piece->type() == PIECE_TYPE_ROOK)
-					return 0;
-
-				curPos += offset;
-				while (curPos != dest && !pieces_[curPos])
-				{
-					curPos += offset;
-				}
-				return curPos == dest;
+				verify = false;
 			}
 		}
-	}
-	else if (piece->type() == PIECE_TYPE_PAWN)
-	{
-		if (!same_half(piece->sidePlayer()->kingPiece()->pos(), piece->pos()) && 
-				(piece->pos() + 1 == dest || piece->pos() - 1 == dest))
+
+		if (!verify || !position_->checkedAfterMove(start, end))
 		{
-			return 1;
+			list.moves[nums++] = list.moves[i];
 		}
-		return dest == piece->forwardStep();
 	}
+	list.size = nums;
+	return nums;
+}
 
-	return false;
+template <MoveGenerateType mgt>
+int Board::generateAllMoves(MoveList& list)
+{
+	int side = currentSide();
+#ifdef CCHESS_BITBOARD_BACKEND
+	for (int type = PIECE_TYPE_KING; type <= PIECE_TYPE_PAWN; ++type)
+	{
+		const uint8_t* pieces = position_->pieceList(side, type);
+		int count = position_->pieceCount(side, type);
+		for (int i = 0; i < count; ++i)
+			generatePieceMoves<mgt>(position_->piecePos(pieces[i]), list);
+	}
+#else
+	generateSideMoves<mgt>(*position_, side, list);
+#endif
+	return list.size;
 }
+template int Board::generateAllMoves<GENERAL>(MoveList& list);
+template int Board::generateAllMoves<CAPTURE>(MoveList& list);
 
-bool Board::legalMove(int mv)
+template <MoveGenerateType mgt, SideType us>
+int Board::generateAllMoves(MoveList& list)
 {
-	bool legal = false;
-	Piece* piece = pieces_[start_of_move(mv)];
-	int dest = end_of_move(mv);
-	if (piece && piece->show() && 
-			piece->sidePlayer() == currentSidePlayer_ && 
-			!piece->sameSide(pieces_[dest]) &&
-			piece->legalMove(pieces_, dest))
+	assert(currentSide() == us);
+#ifdef CCHESS_BITBOARD_BACKEND
+	for (int type = PIECE_TYPE_KING; type <= PIECE_TYPE_PAWN; ++type)
 	{
-		makeMove(mv);
-		if (!willKillSelfKing())
+		const uint8_t* pieces = position_->pieceList(us, type);
+		int count = position_->pieceCount(us, type);
+		for (int i = 0; i < count; ++i)
 		{
-			legal = true;
+			int pos = position_->piecePos(pieces[i]);
+			Bitboard targets = position_->bitboards().generateTargets<mgt>(us, type, pos);
+			while (targets)
+			{
+				int dest = sq_to_pos(pop_lsb(targets));
+				list.add(pos, dest, position_->mvvLva(type, dest));
+			}
 		}
-		undoMove();
 	}
-	return legal;
+#else
+	generateSideMoves<mgt, us>(*position_, list);
+#endif
+	return list.size;
+}
+template int Board::generateAllMoves<GENERAL, SIDE_TYPE_RED>(MoveList& list);
+template int Board::generateAllMoves<GENERAL, SIDE_TYPE_BLACK>(MoveList& list);
+template int Board::generateAllMoves<CAPTURE, SIDE_TYPE_RED>(MoveList& list);
+template int Board::generateAllMoves<CAPTURE, SIDE_TYPE_BLACK>(MoveList& list);
+
+bool Board::isPseudoLegal(Move mv) const
+{
+	int start = mv.start();
+	int dest = mv.end();
+	int pc = position_->pieceAt(start);
+	int selfTag = side_tag(currentSide());
+	return in_board(dest) && (pc & selfTag) &&
+			!(position_->pieceAt(dest) & selfTag) &&
+#ifdef CCHESS_BITBOARD_BACKEND
+			(position_->bitboards().moveTargets(currentSide(), position_->pieceType(pc), pos_to_sq(start)) &
+			 square_bb(pos_to_sq(dest)));
+#else
+			legalMoveByType(*position_, position_->pieceType(pc), start, dest);
+#endif
 }
 
-// 真正走棋的动作
-void Board::makeMove(int mv)
+bool Board::legalMove(Move mv)
 {
-	int start = start_of_move(mv);
-	int end = end_of_move(mv);
-
-	uint32_t zkey = zobristHelper_.getZobrist().key_;
-
-	Piece* endPiece = delPiece(end);
-	Piece* retPiece = delPiece(start);
-	addPiece(retPiece, end);
-
-	int in_check = willKillOpponentKing();
+	return isPseudoLegal(mv) && !position_->checkedAfterMove(mv.start(), mv.end());
+}
 
-	makeHistoryStep(mv, endPiece, in_check, zkey);
+// 真正走棋的动作
+template <MakeMovePolicy policy>
+void Board::makeMove(Move mv)
+{
+	int start = mv.start();
+	int end = mv.end();
+
+	struct step& step = makeHistoryStep(mv);
+	if (policy == COPY_MAKE)
+		pushPosition();
+	step.end_piece = position_->movePiece(start, end);
+
+#ifdef CCHESS_ATTACK_MAPS
+	step.in_check = willKillKing(opponentSide());
+#else
+	// 只需检查走动的棋子以及经过起点、终点的线路是否将军
+	step.in_check = position_->checkedByMove(opponentSide(), start, end);
+#endif
 }
 
-// 撤销上一步走棋
+template void Board::makeMove<MAKE_UNMAKE>(Move mv);
+template void Board::makeMove<COPY_MAKE>(Move mv);
+
+// 撤销上一步走棋，直接恢复走棋前的快照；copy-make只需弹出局面栈
+template <MakeMovePolicy policy>
 void Board::undoMove()
 {
-	if (history_step_records_size == 0) 
+	if (historyStepsSize_ == 0) 
 		return;
 
-	struct step* step = history_step_records[--history_step_records_size];
-	int mv = step->mv;
-	int start = start_of_move(mv);
-	int end = end_of_move(mv);
-
-	Piece* retPiece = delPiece(end);
-	addPiece(retPiece, start);
-	addPiece(step->end_piece, end);
-}
-
-// 将每一步走法记录到历史表
-void Board::makeHistoryStep(int mv, Piece* end_piece, int in_check, uint32_t zobrist_key)
-{
-	// 历史表容量已满则扩增
-	if (history_step_records_size == history_step_records_capacity)
+	const struct step& step = historySteps_[--historyStepsSize_];
+	if (policy == COPY_MAKE)
 	{
-		int new_capacity = (history_step_records_capacity << 1);
-		struct step** steps_record =
-			(struct step**)malloc(sizeof(struct Step*) * new_capacity);
-		history_step_records_capacity = new_capacity;
-		int i = 0;
-		std::copy(history_step_records, 
-							history_step_records + history_step_records_size, 
-							steps_record);
-		std::generate(steps_record + history_step_records_size,
-							steps_record + history_step_records_capacity,
-							[]{return step_create();});
-		free(history_step_records);
-		history_step_records = steps_record;
+		--position_;
+		return;
 	}
-
-	struct step* step = history_step_records[history_step_records_size++];
-	step->mv = mv;
-	step->end_piece = end_piece;
-	step->in_check = in_check;
-	step->zobrist_key = zobrist_key;
+	position_->undoMove(step.mv.start(), step.mv.end(),
+		step.end_piece, step.side, step.zobrist, step.mirror_zobrist, step.value);
 }
+template void Board::undoMove<MAKE_UNMAKE>();
+template void Board::undoMove<COPY_MAKE>();
 
 // 检测重复局面
 int Board::repetitionStatus(int recur)
@@ -714,18 +588,18 @@ int Board::repetitionStatus(int recur)
 	int perp_check = 1;
 	int opponent_perp_check = 1;
 
-	if (history_step_records_size == 0) 
+	if (historyStepsSize_ == 0) 
 		return 0;
 
-	for(int i = history_step_records_size - 1; i >= 0; --i)
+	for(int i = historyStepsSize_ - 1; i >= 0; --i)
 	{
-		struct step* step = history_step_records[i];
-		if (step->mv <= 0 || step->end_piece) break;
+		const struct step& step = historySteps_[i];
+		if (!step.mv || step.end_piece) break;
 
 		if (self_side)
 		{
-			perp_check = perp_check && step->in_check;
-			if (step->zobrist_key == zobristHelper_.getZobrist().key_)
+			perp_check = perp_check && step.in_check;
+			if (step.zobrist.key_ == position_->getZobrist().key_)
 			{
 				if (--recur == 0)
 				{
@@ -735,7 +609,7 @@ int Board::repetitionStatus(int recur)
 		}
 		else 
 		{
-			opponent_perp_check = opponent_perp_check && step->in_check;
+			opponent_perp_check = opponent_perp_check && step.in_check;
 		}
 		self_side = !self_side;
 	}
@@ -744,35 +618,21 @@ int Board::repetitionStatus(int recur)
 }
 
 template <MoveGenerateType mgt>
-int Board::prompt(int pos, int* mvs)
+int Board::prompt(int pos, MoveList& list)
 {
-	Piece* piece = pieces_[pos];
-	int n = 0;
-	int nums = 0;
-	int temp[MAX_GENERATE_MOVES];
-	if (piece && piece->sidePlayer() == currentSidePlayer_)
-	{
-		nums = piece->generateMvs<mgt>(pieces_, temp);
-	}
-	for (int i = 0; i < nums; ++i)
+	if (position_->pieceAt(pos) & side_tag(currentSide()))
 	{
-		makeMove(temp[i]);
-		if (!willKillSelfKing())
-		{
-			mvs[n++] = temp[i];
-		}
-		undoMove();
+		generatePieceMoves<mgt>(pos, list);
 	}
-
-	return n;
+	return filterLegalMoves(list);
 }
-template int Board::prompt<GENERAL>(int pos, int *mvs);
-template int Board::prompt<CAPTURE>(int pos, int *mvs);
+template int Board::prompt<GENERAL>(int pos, MoveList& list);
+template int Board::prompt<CAPTURE>(int pos, MoveList& list);
 
 bool Board::noWayToMove()
 {
-	int mvs[MAX_GENERATE_MOVES];
-	int n = generateAllMovesNoncheck<GENERAL>(mvs);
+	MoveList list;
+	int n = generateAllMovesNoncheck<GENERAL>(list);
 	return n == 0;
 }
 
@@ -785,7 +645,8 @@ void Board::display()
     int row = row_of_pos(i);
     char str[4] = {0};
     const char* space_square = col == 8 ? "+ " : "+-";
-    const char* square_name = this->pieces()[i] ? this->pieces()[i]->cname() : space_square;
+    int pc = position_->pieceAt(i);
+    const char* square_name = pc ? piece_cname[side_of_piece(pc)][position_->pieceType(pc)] : space_square;
     col == 8 ? printf("%s%d", square_name, 9 - row) : printf("%s", square_name);
     if (col == 8)
     {
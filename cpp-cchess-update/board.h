@@ -4,8 +4,11 @@
 #include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
-#include "zobrist_helper.h"
-#include "player_piece.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "position.h"
+#include "generate_move.h"
 
 namespace wsun
 {
@@ -15,155 +18,227 @@ namespace cppupdate
 {
 
 static const int INIT_HISTORY_STEPS_RECORD_SIZE = (2 << 10);
-static const char* INIT_FEN_STRING = "rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR w";
+// 局面栈的初始层数，copy-make搜索时每走一步占用一层
+static const int INIT_POSITION_STACK_SIZE = 128;
+static constexpr const char* INIT_FEN_STRING = "rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR w";
+// toFen输出缓冲区的最小长度(含结尾的'\0')
+static const int MAX_FEN_LENGTH = 128;
 
+// 每一步走棋的记录，同时保存走棋前的局面快照，撤销时直接恢复
 struct step
 {
-	int mv;
-	Piece* end_piece;
-	int in_check;
-	uint32_t zobrist_key;
+	Move mv;
+	int end_piece;			// 被吃掉的棋子编号，0表示没有吃子
+	int in_check;				// 走完这一步之后对方是否被将军
+	int side;						// 走棋前的下棋方
+	Zobrist zobrist;		// 走棋前的zobrist值
+	Zobrist mirror_zobrist;	// 走棋前左右镜像局面的zobrist值
+	int value[2];				// 走棋前双方的子力价值
 };
 
-struct step* step_create();
-void step_release(struct step* step);
-
 class Board
 {
 public:
 	Board(SideType side = SIDE_TYPE_RED)
-		: redPlayer_(new Player(SIDE_TYPE_RED)),
-			blackPlayer_(new Player(SIDE_TYPE_BLACK)),
-			currentSidePlayer_(side == SIDE_TYPE_RED ? redPlayer_ : blackPlayer_)
-	{
-		initPieceArray();
-		initHistoryStepRecords();
-		initFromFen(INIT_FEN_STRING);
-	}
-
-	~Board()
+		: positions_(INIT_POSITION_STACK_SIZE),
+			position_(positions_.data()),
+			historySteps_(INIT_HISTORY_STEPS_RECORD_SIZE)
 	{
-		delete redPlayer_;
-		delete blackPlayer_;
-		releaseHistoryStepRecords();
+		reset();
+		if (side != position_->side())
+		{
+			position_->changeSide();
+			// 下棋方已与起始fen串不同，下次同步时需要完整重置
+			startFenLength_ = 0;
+		}
 	}
 
-	void initPieceArray()
-	{
-		pieces_.fill(nullptr);
-	}
+	// position_指向自己的局面栈，不能拷贝
+	Board(const Board&) = delete;
+	Board& operator=(const Board&) = delete;
 
-	void initHistoryStepRecords();
-	void releaseHistoryStepRecords();
+	// 复制other的当前局面、局面栈和历史走法(用于重复局面检测)，
+	// 多线程搜索时每个线程在自己的棋盘上搜索
+	void copyFrom(const Board& other);
 
 	Board* getExchangeSideBoard() const;
 	Board* getMirrorBoard() const;
 
-	Player* currentSidePlayer() const { return currentSidePlayer_; }
-	const PieceArray& pieces() { return pieces_; }
-	const PieceArray& pieces() const { return pieces_; }
+	const Position& position() const { return *position_; }
+	SideType currentSide() const { return position_->side(); }
+	SideType opponentSide() const { return (SideType)(1 - position_->side()); }
+	int sideValue(SideType side) const { return position_->value(side); }
 	const Zobrist& getZobrist() const
 	{
-		return zobristHelper_.getZobrist();
+		return position_->getZobrist();
+	}
+	// 左右镜像局面的zobrist值，随走棋增量更新
+	const Zobrist& getMirrorZobrist() const
+	{
+		return position_->getMirrorZobrist();
 	}
-	Zobrist getMirrorZobrist() const;
 	void resetData();
 	void addPieceToBoard(PieceType type, SideType side, int pos);
 
-	// 用fen串信息来初始化局面
-	int initFromFen(const char* fen);
+	// 用[fen, end)范围内的fen串信息来初始化局面，局面之后的下棋方写到side，
+	// 返回解析结束的位置(下棋方之后，行尾之前)，不会分配内存
+	const char* initFromFen(const char* fen, const char* end, SideType& side);
 	// 根据fen串信息重置局面
-	void resetFromFen(const char* fen);
+	void resetFromFen(const char* fen)
+	{
+		resetFromFen(fen, fen + strlen(fen));
+	}
+	// 根据[fen, end)范围内的fen串信息原地重置局面，返回解析结束的位置
+	const char* resetFromFen(const char* fen, const char* end);
+	// 按"position fen + moves"的方式同步局面：起始局面与上次相同并且已走的着法是moves的前缀时
+	// 只走新增的着法，否则从fen完整重置后走完所有着法。历史着法都保留在历史表中，
+	// 重复局面检测可以看到整盘棋。遇到不合法的着法就停止，返回同步后历史表中的着法数
+	int syncPosition(const char* fen, const Move* moves, int count);
+	// 解析"startpos|fen <fen串> [moves <着法> ...]"形式的参数并同步局面，不分配内存，
+	// 格式错误时返回-1且局面不变
+	int syncPosition(const char* command);
 	// 重置到最初局面
 	void reset();
 
-	Player* getOpponentPlayerByPlayer(Player* p) const
-	{
-		return (p == redPlayer_ ? blackPlayer_ : redPlayer_);
-	}
-	// 对手player
-	Player* getOpponentPlayer() const
-	{
-		return getOpponentPlayerByPlayer(currentSidePlayer_);
-	}
 	// 更换下棋方
 	void changeSide()
 	{
-		currentSidePlayer_ = getOpponentPlayer();
-		zobristHelper_.updateByChangeSide();
+		position_->changeSide();
 	}
 	// 当前局面评价函数
 	int evaluate() const
 	{
-		return currentSidePlayer_->value() - getOpponentPlayer()->value() + 3;
+		return position_->value(currentSide()) - position_->value(opponentSide()) + 3;
+	}
+	// 下棋方us在编译期确定的版本，用于搜索
+	template <SideType us>
+	int evaluate() const
+	{
+		return position_->value(us) - position_->value(1 - us) + 3;
 	}
 
-	bool willKillKing(Player* player);
+	// side方的帅(将)是否被对方攻击
+	bool willKillKing(SideType side);
 	// 被对手将军
 	bool willKillSelfKing()
 	{
-		return willKillKing(currentSidePlayer_);
+		return willKillKing(currentSide());
 	}
 	// 将对手军
 	bool willKillOpponentKing()
 	{
-		return willKillKing(getOpponentPlayer());
+		return willKillKing(opponentSide());
 	}
 
+	// 当前下棋方是否被将军，直接取上一步走棋时增量计算的结果
+	bool inCheck()
+	{
+		return historyStepsSize_ > 0 ?
+			historySteps_[historyStepsSize_ - 1].in_check != 0 :
+			willKillSelfKing();
+	}
+
+	// 刚走完的一步(尚未换边)是否让己方帅(将)被攻击，即该走法不合法
+	bool movedIntoCheck();
+
+	// pos处的棋子是否被牵制(离开原位置就会让己方帅(将)被攻击)
+	bool pinned(int pos) const
+	{
+		int pc = position_->pieceAt(pos);
+		return pc && (position_->pinnedMask(side_of_piece(pc)) & (1u << (pc - 16)));
+	}
+
+	// 把当前局面的fen串写到buffer，size至少为MAX_FEN_LENGTH，返回fen串长度，
+	// size不够时返回0
+	int toFen(char* buffer, int size) const;
 	// 根据当前局面输出fen格式的局面信息
-	std::string toFen();
+	std::string toFen() const
+	{
+		char buffer[MAX_FEN_LENGTH];
+		return std::string(buffer, toFen(buffer, MAX_FEN_LENGTH));
+	}
 
-	// 生成某棋子所有的走法(注意：不存在走完之后依然被对方将军),
+	// 生成pos处棋子所有的走法并追加到list(注意：可能存在走完之后依然被对方将军的走法),
 	// capatured: 是否只生成吃子走法
-	int generateMoves(Piece* piece, int* mvs, bool capatured);
+	int generateMoves(int pos, MoveList& list, bool capatured);
 
+	// 生成当前下棋方所有的伪合法走法并追加到list，返回list中的走法数
 	template <MoveGenerateType mgt>
-	int generateAllMoves(int *mvs);
+	int generateAllMoves(MoveList& list);
+	// 下棋方us在编译期确定的版本，用于搜索，us必须是当前下棋方
+	template <MoveGenerateType mgt, SideType us>
+	int generateAllMoves(MoveList& list);
 
-	// 生成所有棋子所有的走法 capatured: 是否只生成吃子走法
+	// 生成所有棋子所有的合法走法 capatured: 是否只生成吃子走法
+	// 被将军时只保留解将着法，不需要逐个走棋和撤销
 	template <MoveGenerateType mgt>
-	int generateAllMovesNoncheck(int* mvs);
+	int generateAllMovesNoncheck(MoveList& list);
+
+	// 在list中就地挑出当前下棋方的合法走法，返回合法走法数
+	int filterLegalMoves(MoveList& list);
 
 	// 困毙，是否无棋可走
 	bool noWayToMove();
 
-	void addPiece(Piece* piece, int pos);
-	Piece* delPiece(int pos);
+	// 只检查走法的几何规则和棋子占位：起点是走棋方的棋子，终点在棋盘上并且不是己方棋子，
+	// 并且该棋子能从起点走到终点，不检查走完之后是否被将军。
+	// 用于校验置换表和杀手表中的走法，它们可能来自别的局面
+	bool isPseudoLegal(Move mv) const;
 
-	bool legalMovePiece1(Piece* piece, int dest);
-	bool legalMove(int mv);
+	// 伪合法并且走完之后己方帅(将)不会被攻击
+	bool legalMove(Move mv);
 
-	// 真正走棋的动作
-	void makeMove(int mv);
+	// 真正走棋的动作，policy为COPY_MAKE时先把局面复制到局面栈的下一层
+	template <MakeMovePolicy policy = MAKE_UNMAKE>
+	void makeMove(Move mv);
 
-	// 撤销上一步走棋
+	// 撤销上一步走棋，必须与走棋时的policy一致
+	template <MakeMovePolicy policy = MAKE_UNMAKE>
 	void undoMove();
 
-	// 将每一步走法记录到历史表
-	void makeHistoryStep(int mv, Piece* end_piece, int inCheck, uint32_t zobristKey);
+	// 在历史表中新增一步，记录走法和走棋前的局面快照
+	struct step& makeHistoryStep(Move mv)
+	{
+		// 历史表容量已满则扩增(只会发生在很长的对局中，搜索时不会分配内存)
+		if (historyStepsSize_ == (int)historySteps_.size())
+			historySteps_.resize(historySteps_.size() << 1);
+
+		struct step& step = historySteps_[historyStepsSize_++];
+		step.mv = mv;
+		step.end_piece = 0;
+		step.in_check = 0;
+		step.side = position_->side();
+		step.zobrist = position_->getZobrist();
+		step.mirror_zobrist = position_->getMirrorZobrist();
+		step.value[0] = position_->value(SIDE_TYPE_RED);
+		step.value[1] = position_->value(SIDE_TYPE_BLACK);
+		return step;
+	}
 
 	void makeNullMove()
 	{
-		makeHistoryStep(0, 0, 0, zobristHelper_.getZobrist().key_);
+		makeHistoryStep(Move());
 	}
 
 	void undoNullMove()
 	{
-		--history_step_records_size;
+		--historyStepsSize_;
 	}
 
 	// 用于AI
-	int mvvLva(int mv)
+	int mvvLva(Move mv)
 	{
-		int start = start_of_move(mv);
-		int end = end_of_move(mv);
-		
-		// 必须是吃子着法
-		//assert(board->pieces[start] && board->pieces[end]);
+		return position_->mvvLva(position_->typeAt(mv.start()), mv.end());
+	}
 
-		int mvv = array_mvv_lva[pieces_[end]->type()] * 10;
-		int lva = array_mvv_lva[pieces_[start]->type()];
-		return mvv - lva;
+	// 吃子走法的静态交换评估，见Position::see
+	int see(Move mv)
+	{
+		return position_->see(mv.start(), mv.end());
+	}
+	bool losingCapture(Move mv)
+	{
+		return position_->losingCapture(mv.start(), mv.end());
 	}
 
 	// 检测重复局面
@@ -173,14 +248,27 @@ public:
 
 	// 选子提示所有走法
 	template <MoveGenerateType mgt>
-	int prompt(int pos, int* mvs);
+	int prompt(int pos, MoveList& list);
+
+	// 走mv是否将军对方，不用真正走棋
+	bool givesCheck(Move mv)
+	{
+		return position_->givesCheck(mv.start(), mv.end());
+	}
+
+	// 被吃棋子的子力价值，不吃子为0
+	int captureValue(Move mv)
+	{
+		int pc = position_->pieceAt(mv.end());
+		return pc ? Position::pieceValue(side_of_piece(pc), position_->typeAt(mv.end()), mv.end()) : 0;
+	}
 
-	bool isCapatured(int mv)
+	bool isCapatured(Move mv)
 	{
-		return pieces_[end_of_move(mv)] != NULL;
+		return position_->pieceAt(mv.end()) != 0;
 	}
 
-	void play(int mv)
+	void play(Move mv)
 	{
 		if (isCapatured(mv))
 		{
@@ -197,8 +285,7 @@ public:
 
 	void play(const char* iccs_mv)
 	{
-		int mv = iccs_move_to_move(iccs_mv);
-		play(mv);
+		play(Move(iccs_move_to_move(iccs_mv)));
 	}
 
 	void backOneStep()
@@ -216,16 +303,50 @@ public:
   void display();
 
 private:
-	Player* redPlayer_;				// 红方
-	Player* blackPlayer_;			// 黑方
-	Player* currentSidePlayer_;		// 当前下棋方
-	PieceArray pieces_;			// 棋盘上的所有棋子
+	// 生成pos处棋子的走法并追加到list
+	template <MoveGenerateType mgt>
+	void generatePieceMoves(int pos, MoveList& list)
+	{
+		int pc = position_->pieceAt(pos);
+#ifdef CCHESS_BITBOARD_BACKEND
+		int type = position_->pieceType(pc);
+		Bitboard targets = position_->bitboards().generateTargets<mgt>(side_of_piece(pc), type, pos);
+		while (targets)
+		{
+			int dest = sq_to_pos(pop_lsb(targets));
+			list.add(pos, dest, position_->mvvLva(type, dest));
+		}
+#else
+		generateMovesByType<mgt>(*position_, position_->pieceType(pc), pos, list);
+#endif
+	}
+
+	// 当前局面是否由[fen, end)所表示的起始局面开始走棋得到
+	bool sameStartFen(const char* fen, const char* end) const;
+	// 从历史表的第index步开始依次走完moves中的着法
+	int syncMoves(int index, const Move* moves, int count);
+
+	// 把当前局面复制到局面栈的下一层，并作为当前局面
+	void pushPosition()
+	{
+		// 局面栈已满则扩增(只会发生在极深的搜索中)
+		if (position_ + 1 == positions_.data() + positions_.size())
+		{
+			size_t top = position_ - positions_.data();
+			positions_.resize(positions_.size() << 1);
+			position_ = positions_.data() + top;
+		}
+		position_[1] = position_[0];
+		++position_;
+	}
 
-	struct step** history_step_records;
-	int history_step_records_size;
-	int history_step_records_capacity;
+	std::vector<Position> positions_;	// 局面栈，copy-make搜索时逐层使用
+	Position* position_;							// 当前局面，指向局面栈中的某一层
+	char startFen_[MAX_FEN_LENGTH];	// 起始局面的fen串(只含局面和下棋方)
+	int startFenLength_ = 0;				// 为0表示起始局面未知
 
-	ZobristHelper zobristHelper_;
+	std::vector<struct step> historySteps_;		// 连续存放的历史表，预先分配好
+	int historyStepsSize_ = 0;
 
 	int accumStepsFromCapture_ = 0;
 	int turnNums_ = 1;
@@ -2,6 +2,8 @@
 #define __WSUN_CCHESS_CPP_UPDATE_CONSTANTS_H__
 
 #include <array>
+#include <inttypes.h>
+#include <stddef.h>
 
 namespace wsun
 {
@@ -10,286 +12,256 @@ namespace cchess
 namespace cppupdate
 {
 
-static const std::array<int, 256> array_in_borad =
+enum PieceType : int
 {
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
-  0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
-  0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
-  0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
-  0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
-  0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
-  0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
-  0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
-  0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
-  0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+	PIECE_TYPE_NONE = -1,
+	PIECE_TYPE_KING = 0,
+	PIECE_TYPE_ADVISOR = 1,
+	PIECE_TYPE_BISHOP = 2,
+	PIECE_TYPE_KNIGHT = 3,
+	PIECE_TYPE_ROOK = 4,
+	PIECE_TYPE_CANNON = 5,
+	PIECE_TYPE_PAWN = 6,
+	PIECE_TYPE_NUMBER
 };
 
-static const std::array<int, 256> array_in_fort =
+enum MoveGenerateType : int
 {
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+	CAPTURE,
+	GENERAL
 };
 
-static const std::array<int, 512> array_legal_span =
+// 搜索时走棋和撤销的方式
+enum MakeMovePolicy : int
 {
-                       0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 3, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 2, 1, 2, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 2, 1, 2, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 3, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-  0, 0, 0, 0, 0, 0, 0
+	MAKE_UNMAKE,	// 在同一个局面上走棋，撤销时把棋子挪回去并恢复快照
+	COPY_MAKE			// 走棋前把局面复制到局面栈的下一层再走，撤销时直接弹出
 };
 
-static const std::array<int, 512> array_knight_pin =
+enum SideType : int
 {
-                              0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,-16,  0,-16,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0, -1,  0,  0,  0,  1,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0, -1,  0,  0,  0,  1,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0, 16,  0, 16,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-  0,  0,  0,  0,  0,  0,  0
+	SIDE_TYPE_RED = 0,
+	SIDE_TYPE_BLACK = 1,
+	SIDE_TYPE_NUMBER = 2
 };
 
-static const std::array<int, 4> array_king_delta = { -16, -1, 1, 16 };
+static constexpr std::array<int, 4> array_king_delta = { -16, -1, 1, 16 };
 
-static const std::array<int, 4> array_advisor_delta = { -17, -15, 15, 17 };
+static constexpr std::array<int, 4> array_advisor_delta = { -17, -15, 15, 17 };
 
-static const int array_knight_delta[4][2] = {
+// 马的走法，第i组的马腿为array_king_delta[i]
+static constexpr int array_knight_delta[4][2] = {
 	{-33, -31},
 	{-18, 14},
 	{-14, 18},
 	{31, 33}
 };
 
-static const int array_knight_check_delta[4][2] = {
+static constexpr int array_knight_check_delta[4][2] = {
 	{-33, -18},
 	{-31, -14},
 	{14, 31},
 	{18, 33}
 };
 
-static const std::array<int, 256> array_piece_value[7] = {
+// 以下棋盘表在编译期由棋盘几何生成，用窄类型存放，和棋盘一起常驻L1缓存；
+// 按16x16棋盘的位置索引，或者按两个位置之差加256索引
+
+constexpr bool geometry_in_board(int pos)
+{
+	return (pos >> 4) >= 3 && (pos >> 4) <= 12 && (pos & 15) >= 3 && (pos & 15) <= 11;
+}
+
+constexpr bool geometry_in_fort(int pos)
+{
+	int row = pos >> 4;
+	int col = pos & 15;
+	return col >= 6 && col <= 8 && ((row >= 3 && row <= 5) || (row >= 10 && row <= 12));
+}
+
+constexpr std::array<uint8_t, 256> make_in_board()
+{
+	std::array<uint8_t, 256> table {};
+	for (int pos = 0; pos < 256; ++pos)
+		table[pos] = geometry_in_board(pos);
+	return table;
+}
+
+constexpr std::array<uint8_t, 256> make_in_fort()
+{
+	std::array<uint8_t, 256> table {};
+	for (int pos = 0; pos < 256; ++pos)
+		table[pos] = geometry_in_fort(pos);
+	return table;
+}
+
+// 帅(将)一步为1，仕(士)一步为2，相(象)一步为3
+constexpr std::array<int8_t, 512> make_legal_span()
+{
+	std::array<int8_t, 512> table {};
+	for (int i = 0; i < 4; ++i)
+	{
+		table[256 + array_king_delta[i]] = 1;
+		table[256 + array_advisor_delta[i]] = 2;
+		table[256 + array_advisor_delta[i] * 2] = 3;
+	}
+	return table;
+}
+
+// 马走一步对应的马腿方向，不是马的走法为0
+constexpr std::array<int8_t, 512> make_knight_pin()
+{
+	std::array<int8_t, 512> table {};
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 2; ++j)
+			table[256 + array_knight_delta[i][j]] = (int8_t)array_king_delta[i];
+	}
+	return table;
+}
+
+// 红方视角的子力位置价值，按棋盘上的行(从黑方底线开始)、列排列
+static constexpr uint8_t piece_square_value[PIECE_TYPE_NUMBER][10][9] = {
 	{ // 帅(将)
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  1,  1,  1,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  2,  2,  2,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0, 11, 15, 11,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-  }, { // 仕(士)
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0, 20,  0, 20,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0, 23,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0, 20,  0, 20,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-  }, { // 相(象)
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0, 20,  0,  0,  0, 20,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0, 18,  0,  0,  0, 23,  0,  0,  0, 18,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0, 20,  0,  0,  0, 20,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-  }, { // 马
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0, 90, 90, 90, 96, 90, 96, 90, 90, 90,  0,  0,  0,  0,
-    0,  0,  0, 90, 96,103, 97, 94, 97,103, 96, 90,  0,  0,  0,  0,
-    0,  0,  0, 92, 98, 99,103, 99,103, 99, 98, 92,  0,  0,  0,  0,
-    0,  0,  0, 93,108,100,107,100,107,100,108, 93,  0,  0,  0,  0,
-    0,  0,  0, 90,100, 99,103,104,103, 99,100, 90,  0,  0,  0,  0,
-    0,  0,  0, 90, 98,101,102,103,102,101, 98, 90,  0,  0,  0,  0,
-    0,  0,  0, 92, 94, 98, 95, 98, 95, 98, 94, 92,  0,  0,  0,  0,
-    0,  0,  0, 93, 92, 94, 95, 92, 95, 94, 92, 93,  0,  0,  0,  0,
-    0,  0,  0, 85, 90, 92, 93, 78, 93, 92, 90, 85,  0,  0,  0,  0,
-    0,  0,  0, 88, 85, 90, 88, 90, 88, 90, 85, 88,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-  }, { // 车
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,206,208,207,213,214,213,207,208,206,  0,  0,  0,  0,
-    0,  0,  0,206,212,209,216,233,216,209,212,206,  0,  0,  0,  0,
-    0,  0,  0,206,208,207,214,216,214,207,208,206,  0,  0,  0,  0,
-    0,  0,  0,206,213,213,216,216,216,213,213,206,  0,  0,  0,  0,
-    0,  0,  0,208,211,211,214,215,214,211,211,208,  0,  0,  0,  0,
-    0,  0,  0,208,212,212,214,215,214,212,212,208,  0,  0,  0,  0,
-    0,  0,  0,204,209,204,212,214,212,204,209,204,  0,  0,  0,  0,
-    0,  0,  0,198,208,204,212,212,212,204,208,198,  0,  0,  0,  0,
-    0,  0,  0,200,208,206,212,200,212,206,208,200,  0,  0,  0,  0,
-    0,  0,  0,194,206,204,212,200,212,204,206,194,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-  }, { // 炮
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,100,100, 96, 91, 90, 91, 96,100,100,  0,  0,  0,  0,
-    0,  0,  0, 98, 98, 96, 92, 89, 92, 96, 98, 98,  0,  0,  0,  0,
-    0,  0,  0, 97, 97, 96, 91, 92, 91, 96, 97, 97,  0,  0,  0,  0,
-    0,  0,  0, 96, 99, 99, 98,100, 98, 99, 99, 96,  0,  0,  0,  0,
-    0,  0,  0, 96, 96, 96, 96,100, 96, 96, 96, 96,  0,  0,  0,  0,
-    0,  0,  0, 95, 96, 99, 96,100, 96, 99, 96, 95,  0,  0,  0,  0,
-    0,  0,  0, 96, 96, 96, 96, 96, 96, 96, 96, 96,  0,  0,  0,  0,
-    0,  0,  0, 97, 96,100, 99,101, 99,100, 96, 97,  0,  0,  0,  0,
-    0,  0,  0, 96, 97, 98, 98, 98, 98, 98, 97, 96,  0,  0,  0,  0,
-    0,  0,  0, 96, 96, 97, 99, 99, 99, 97, 96, 96,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-  }, { // 兵(卒)
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  9,  9,  9, 11, 13, 11,  9,  9,  9,  0,  0,  0,  0,
-    0,  0,  0, 19, 24, 34, 42, 44, 42, 34, 24, 19,  0,  0,  0,  0,
-    0,  0,  0, 19, 24, 32, 37, 37, 37, 32, 24, 19,  0,  0,  0,  0,
-    0,  0,  0, 19, 23, 27, 29, 30, 29, 27, 23, 19,  0,  0,  0,  0,
-    0,  0,  0, 14, 18, 20, 27, 29, 27, 20, 18, 14,  0,  0,  0,  0,
-    0,  0,  0,  7,  0, 13,  0, 16,  0, 13,  0,  7,  0,  0,  0,  0,
-    0,  0,  0,  7,  0,  7,  0, 15,  0,  7,  0,  7,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0
-  }
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   1,   1,   1,   0,   0,   0},
+		{  0,   0,   0,   2,   2,   2,   0,   0,   0},
+		{  0,   0,   0,  11,  15,  11,   0,   0,   0}
+	}, { // 仕(士)
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,  20,   0,  20,   0,   0,   0},
+		{  0,   0,   0,   0,  23,   0,   0,   0,   0},
+		{  0,   0,   0,  20,   0,  20,   0,   0,   0}
+	}, { // 相(象)
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,  20,   0,   0,   0,  20,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{ 18,   0,   0,   0,  23,   0,   0,   0,  18},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,  20,   0,   0,   0,  20,   0,   0}
+	}, { // 马
+		{ 90,  90,  90,  96,  90,  96,  90,  90,  90},
+		{ 90,  96, 103,  97,  94,  97, 103,  96,  90},
+		{ 92,  98,  99, 103,  99, 103,  99,  98,  92},
+		{ 93, 108, 100, 107, 100, 107, 100, 108,  93},
+		{ 90, 100,  99, 103, 104, 103,  99, 100,  90},
+		{ 90,  98, 101, 102, 103, 102, 101,  98,  90},
+		{ 92,  94,  98,  95,  98,  95,  98,  94,  92},
+		{ 93,  92,  94,  95,  92,  95,  94,  92,  93},
+		{ 85,  90,  92,  93,  78,  93,  92,  90,  85},
+		{ 88,  85,  90,  88,  90,  88,  90,  85,  88}
+	}, { // 车
+		{206, 208, 207, 213, 214, 213, 207, 208, 206},
+		{206, 212, 209, 216, 233, 216, 209, 212, 206},
+		{206, 208, 207, 214, 216, 214, 207, 208, 206},
+		{206, 213, 213, 216, 216, 216, 213, 213, 206},
+		{208, 211, 211, 214, 215, 214, 211, 211, 208},
+		{208, 212, 212, 214, 215, 214, 212, 212, 208},
+		{204, 209, 204, 212, 214, 212, 204, 209, 204},
+		{198, 208, 204, 212, 212, 212, 204, 208, 198},
+		{200, 208, 206, 212, 200, 212, 206, 208, 200},
+		{194, 206, 204, 212, 200, 212, 204, 206, 194}
+	}, { // 炮
+		{100, 100,  96,  91,  90,  91,  96, 100, 100},
+		{ 98,  98,  96,  92,  89,  92,  96,  98,  98},
+		{ 97,  97,  96,  91,  92,  91,  96,  97,  97},
+		{ 96,  99,  99,  98, 100,  98,  99,  99,  96},
+		{ 96,  96,  96,  96, 100,  96,  96,  96,  96},
+		{ 95,  96,  99,  96, 100,  96,  99,  96,  95},
+		{ 96,  96,  96,  96,  96,  96,  96,  96,  96},
+		{ 97,  96, 100,  99, 101,  99, 100,  96,  97},
+		{ 96,  97,  98,  98,  98,  98,  98,  97,  96},
+		{ 96,  96,  97,  99,  99,  99,  97,  96,  96}
+	}, { // 兵(卒)
+		{  9,   9,   9,  11,  13,  11,   9,   9,   9},
+		{ 19,  24,  34,  42,  44,  42,  34,  24,  19},
+		{ 19,  24,  32,  37,  37,  37,  32,  24,  19},
+		{ 19,  23,  27,  29,  30,  29,  27,  23,  19},
+		{ 14,  18,  20,  27,  29,  27,  20,  18,  14},
+		{  7,   0,  13,   0,  16,   0,  13,   0,   7},
+		{  7,   0,   7,   0,  15,   0,   7,   0,   7},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0},
+		{  0,   0,   0,   0,   0,   0,   0,   0,   0}
+	}
 };
 
-static const std::array<const char*, 2> fen_piece_char = {"KABNRCP", "kabnrcp"};
+typedef std::array<std::array<uint8_t, 256>, PIECE_TYPE_NUMBER> PieceSquareTable;
+
+// 双方各自视角的子力位置价值，黑方的表已经按254 - pos翻转好
+constexpr std::array<PieceSquareTable, SIDE_TYPE_NUMBER> make_piece_value()
+{
+	std::array<PieceSquareTable, SIDE_TYPE_NUMBER> table {};
+	for (int type = 0; type < PIECE_TYPE_NUMBER; ++type)
+	{
+		for (int pos = 0; pos < 256; ++pos)
+		{
+			if (!geometry_in_board(pos)) continue;
+			uint8_t value = piece_square_value[type][(pos >> 4) - 3][(pos & 15) - 3];
+			table[SIDE_TYPE_RED][type][pos] = value;
+			table[SIDE_TYPE_BLACK][type][254 - pos] = value;
+		}
+	}
+	return table;
+}
 
-static const std::array<int, 7> array_mvv_lva = {5, 1, 1, 3, 4, 3, 2};
+static constexpr std::array<uint8_t, 256> array_in_borad = make_in_board();
+static constexpr std::array<uint8_t, 256> array_in_fort = make_in_fort();
+static constexpr std::array<int8_t, 512> array_legal_span = make_legal_span();
+static constexpr std::array<int8_t, 512> array_knight_pin = make_knight_pin();
+static constexpr std::array<PieceSquareTable, SIDE_TYPE_NUMBER> array_piece_value = make_piece_value();
 
-enum PieceType : int
+// 校验生成的表与原先手写的int表完全相同(按int值计算FNV-1a)
+template <typename T, size_t N>
+constexpr uint64_t table_checksum(const std::array<T, N>& table, uint64_t hash = 14695981039346656037ull)
 {
-	PIECE_TYPE_NONE = -1,
-	PIECE_TYPE_KING = 0,
-	PIECE_TYPE_ADVISOR = 1,
-	PIECE_TYPE_BISHOP = 2,
-	PIECE_TYPE_KNIGHT = 3,
-	PIECE_TYPE_ROOK = 4,
-	PIECE_TYPE_CANNON = 5,
-	PIECE_TYPE_PAWN = 6,
-	PIECE_TYPE_NUMBER
-};
+	for (size_t i = 0; i < N; ++i)
+	{
+		hash ^= (uint32_t)(int)table[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
 
-enum MoveGenerateType : int
+constexpr uint64_t piece_value_checksum(int side)
 {
-	CAPTURE,
-	GENERAL
-};
+	uint64_t hash = 14695981039346656037ull;
+	for (int type = 0; type < PIECE_TYPE_NUMBER; ++type)
+		hash = table_checksum(array_piece_value[side][type], hash);
+	return hash;
+}
+
+static_assert(table_checksum(array_in_borad) == 0x6f49e26d925f0165ull, "array_in_borad changed");
+static_assert(table_checksum(array_in_fort) == 0x6eefb6123e2016e5ull, "array_in_fort changed");
+static_assert(table_checksum(array_legal_span) == 0xcfa7c114e7223cfdull, "array_legal_span changed");
+static_assert(table_checksum(array_knight_pin) == 0x90ae4637859c9625ull, "array_knight_pin changed");
+static_assert(piece_value_checksum(SIDE_TYPE_RED) == 0xf949a3d495d01995ull, "red piece values changed");
+static_assert(piece_value_checksum(SIDE_TYPE_BLACK) == 0xa78590e95e3953c5ull, "black piece values changed");
+
+static const std::array<const char*, 2> fen_piece_char = {"KABNRCP", "kabnrcp"};
+
+static constexpr std::array<uint8_t, PIECE_TYPE_NUMBER> array_mvv_lva = {5, 1, 1, 3, 4, 3, 2};
 
-class Piece;
-typedef std::array<Piece*,256> PieceArray;
+static const char* const piece_cname[2][7] = {
+	{"帅", "仕", "相", "马", "车", "炮", "兵"},
+	{"将", "士", "象", "马", "车", "炮", "卒"}
+};
 
 //static const int PIECE_TYPE_KING = 0;
 //static const int PIECE_TYPE_ADVISOR = 1;
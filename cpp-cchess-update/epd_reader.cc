@@ -0,0 +1,91 @@
+#include "epd_reader.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace wsun
+{
+namespace cchess
+{
+namespace cppupdate
+{
+
+EpdReader::EpdReader(const char* path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0)
+	{
+		size_ = (size_t)st.st_size;
+		if (size_ == 0)
+		{
+			opened_ = true;
+		}
+		else
+		{
+			void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (addr != MAP_FAILED)
+			{
+				// 顺序读取，提示内核提前预读
+				madvise(addr, size_, MADV_SEQUENTIAL);
+				data_ = (const char*)addr;
+				opened_ = true;
+			}
+			else
+			{
+				size_ = 0;
+			}
+		}
+	}
+	// 映射建立之后就不再需要文件描述符
+	close(fd);
+	cursor_ = data_;
+}
+
+EpdReader::~EpdReader()
+{
+	if (data_)
+		munmap((void*)data_, size_);
+}
+
+bool EpdReader::next(Board& board, const char** ops, int* opsLength)
+{
+	const char* end = data_ + size_;
+	while (cursor_ < end)
+	{
+		const char* line = cursor_;
+		const char* eol = (const char*)memchr(line, '\n', end - line);
+		if (!eol)
+			eol = end;
+		cursor_ = eol < end ? eol + 1 : end;
+
+		// 去掉行首空白以及Windows换行的'\r'
+		while (line < eol && (*line == ' ' || *line == '\t'))
+			++line;
+		const char* lineEnd = eol;
+		if (lineEnd > line && lineEnd[-1] == '\r')
+			--lineEnd;
+		if (line == lineEnd || *line == '#')
+			continue;
+
+		const char* rest = board.resetFromFen(line, lineEnd);
+		if (ops)
+		{
+			while (rest < lineEnd && (*rest == ' ' || *rest == '\t'))
+				++rest;
+			*ops = rest;
+			if (opsLength)
+				*opsLength = (int)(lineEnd - rest);
+		}
+		return true;
+	}
+	return false;
+}
+
+} // namespace cppupdate
+} // namespace cchess
+} // namespace wsun
@@ -0,0 +1,47 @@
+#ifndef __WSUN_CCHESS_CPP_UPDATE_EPD_READER_H__
+#define __WSUN_CCHESS_CPP_UPDATE_EPD_READER_H__
+
+#include "board.h"
+#include <stddef.h>
+
+namespace wsun
+{
+namespace cchess
+{
+namespace cppupdate
+{
+
+// 批量读取EPD/FEN文件，每行一个局面，行内局面之后的内容为EPD操作(如"bm h2e2;")
+// 整个文件以只读方式映射到内存，逐行原地解析到Board中，读取过程不分配内存
+class EpdReader
+{
+public:
+	explicit EpdReader(const char* path);
+	~EpdReader();
+
+	EpdReader(const EpdReader&) = delete;
+	EpdReader& operator=(const EpdReader&) = delete;
+
+	// 文件是否成功打开(空文件也算打开成功，只是没有局面)
+	bool isOpen() const { return opened_; }
+	size_t fileSize() const { return size_; }
+
+	// 读取下一个局面到board，跳过空行和以'#'开头的注释行，没有更多局面时返回false
+	// ops(可选)指向局面之后、行尾之前的EPD操作，opsLength为其长度，不以'\0'结尾
+	bool next(Board& board, const char** ops = nullptr, int* opsLength = nullptr);
+
+	// 回到文件开头重新读取
+	void rewind() { cursor_ = data_; }
+
+private:
+	const char* data_ = nullptr;
+	const char* cursor_ = nullptr;
+	size_t size_ = 0;
+	bool opened_ = false;
+};
+
+} // namespace cppupdate
+} // namespace cchess
+} // namespace wsun
+
+#endif // __WSUN_CCHESS_CPP_UPDATE_EPD_READER_H__
@@ -1,5 +1,6 @@
+
 #include "generate_move.h"
-#include "player_piece.h"
+#include "position.h"
 #include <assert.h>
 
 namespace wsun
@@ -9,422 +10,406 @@ namespace cchess
 namespace cppupdate
 {
 
-template <>
-bool legalMovePiece<PIECE_TYPE_KING>(Piece* piece, const PieceArray& pieces, int dest)
+namespace
+{
+
+// 在长度为len的一行(列)上，从idx出发，按占位occ计算车、炮的走法
+constexpr SlideMask make_slide_mask(int len, int idx, int occ)
+{
+	SlideMask m {};
+	for (int step = -1; step <= 1; step += 2)
+	{
+		int i = idx + step;
+		while (i >= 0 && i < len && !(occ & (1 << i)))
+		{
+			m.nonCap |= (uint16_t)(1 << (i + 3));
+			i += step;
+		}
+		if (i < 0 || i >= len) continue;
+		m.rookCap |= (uint16_t)(1 << (i + 3));
+		i += step;
+		while (i >= 0 && i < len && !(occ & (1 << i)))
+			i += step;
+		if (i >= 0 && i < len)
+			m.cannonCap |= (uint16_t)(1 << (i + 3));
+	}
+	return m;
+}
+
+constexpr SlideTables make_slide_tables()
+{
+	SlideTables t {};
+	for (int x = 0; x < 9; ++x)
+		for (int occ = 0; occ < (1 << 9); ++occ)
+			t.rank[x][occ] = make_slide_mask(9, x, occ);
+	for (int y = 0; y < 10; ++y)
+		for (int occ = 0; occ < (1 << 10); ++occ)
+			t.file[y][occ] = make_slide_mask(10, y, occ);
+	return t;
+}
+
+} // namespace
+
+constexpr SlideTables slide_tables = make_slide_tables();
+
+// pos所在行、列上车、炮的走法
+inline static const SlideMask& rank_slide(const Position& position, int pos)
+{
+	return slide_tables.rank[(pos & 15) - 3][(position.rankBits(pos) >> 3) & 0x1ff];
+}
+
+inline static const SlideMask& file_slide(const Position& position, int pos)
+{
+	return slide_tables.file[(pos >> 4) - 3][(position.fileBits(pos) >> 3) & 0x3ff];
+}
+
+// 把行(列)上的位掩码转换为走法，只吃tag方的棋子(tag为0则不检查)
+inline static void rank_mask_moves(const Position& position, PieceType pt, int pos, int mask, int tag, MoveList& list)
+{
+	while (mask)
+	{
+		int dest = (pos & 0xf0) | __builtin_ctz(mask);
+		mask &= mask - 1;
+		if (!tag || (position.pieceAt(dest) & tag))
+			list.add(pos, dest, position.mvvLva(pt, dest));
+	}
+}
+
+inline static void file_mask_moves(const Position& position, PieceType pt, int pos, int mask, int tag, MoveList& list)
 {
-	if (in_fort(dest) && array_legal_span[dest - piece->pos() + 256] == 1) return true;
-	int offset = get_offset(piece->pos(), dest);
-	if (offset == 0) return false;
-	int curPos = piece->pos() + offset;
-	while (curPos != dest && !pieces[curPos])
+	while (mask)
 	{
-		curPos += offset;
+		int dest = (__builtin_ctz(mask) << 4) | (pos & 0x0f);
+		mask &= mask - 1;
+		if (!tag || (position.pieceAt(dest) & tag))
+			list.add(pos, dest, position.mvvLva(pt, dest));
 	}
-	return curPos == dest && piece->oppSide(pieces[dest]) && pieces[dest]->type() == PIECE_TYPE_KING;
 }
 
 template <>
-bool legalMovePiece<PIECE_TYPE_ADVISOR>(Piece* piece, const PieceArray& pieces, int dest)
+bool legalMovePiece<PIECE_TYPE_KING>(const Position& position, int pos, int dest)
 {
-	return in_fort(dest) && array_legal_span[dest - piece->pos() + 256] == 2;
+	if (in_fort(dest) && array_legal_span[dest - pos + 256] == 1) return true;
+	// 帅(将)照面
+	if (!same_col(pos, dest) || !(file_slide(position, pos).rookCap & (1 << (dest >> 4))))
+		return false;
+	int oppTag = opp_side_tag(side_of_piece(position.pieceAt(pos)));
+	return (position.pieceAt(dest) & oppTag) && position.typeAt(dest) == PIECE_TYPE_KING;
 }
 
 template <>
-bool legalMovePiece<PIECE_TYPE_BISHOP>(Piece* piece, const PieceArray& pieces, int dest)
+bool legalMovePiece<PIECE_TYPE_ADVISOR>(const Position&, int pos, int dest)
 {
-	return same_half(piece->pos(), dest) &&
-				 array_legal_span[dest - piece->pos() + 256] == 3 &&
-				 !pieces[((piece->pos() + dest) >> 1)];
+	return in_fort(dest) && array_legal_span[dest - pos + 256] == 2;
 }
 
 template <>
-bool legalMovePiece<PIECE_TYPE_KNIGHT>(Piece* piece, const PieceArray& pieces, int dest)
+bool legalMovePiece<PIECE_TYPE_BISHOP>(const Position& position, int pos, int dest)
 {
-	return piece->pos() != piece->pos() + array_knight_pin[dest - piece->pos() + 256] && 
-				 !pieces[(piece->pos() + array_knight_pin[dest - piece->pos() + 256])];
+	return same_half(pos, dest) &&
+				 array_legal_span[dest - pos + 256] == 3 &&
+				 !position.pieceAt((pos + dest) >> 1);
 }
 
 template <>
-bool legalMovePiece<PIECE_TYPE_ROOK>(Piece* piece, const PieceArray& pieces, int dest)
+bool legalMovePiece<PIECE_TYPE_KNIGHT>(const Position& position, int pos, int dest)
 {
-	int offset = get_offset(piece->pos(), dest);
-	if (offset == 0) return false;
+	return pos != pos + array_knight_pin[dest - pos + 256] &&
+				 !position.pieceAt(pos + array_knight_pin[dest - pos + 256]);
+}
 
-	int curPos = piece->pos() + offset;
-	while (curPos != dest && !pieces[curPos])
+template <>
+bool legalMovePiece<PIECE_TYPE_ROOK>(const Position& position, int pos, int dest)
+{
+	int mask = 0;
+	if (same_row(pos, dest))
+	{
+		const SlideMask& rank = rank_slide(position, pos);
+		mask = (rank.nonCap | rank.rookCap) & (1 << (dest & 15));
+	}
+	else if (same_col(pos, dest))
 	{
-		curPos += offset;
+		const SlideMask& file = file_slide(position, pos);
+		mask = (file.nonCap | file.rookCap) & (1 << (dest >> 4));
 	}
-	return curPos == dest && !piece->sameSide(pieces[dest]);
+	int selfTag = side_tag(side_of_piece(position.pieceAt(pos)));
+	return mask && !(position.pieceAt(dest) & selfTag);
 }
 
 template <>
-bool legalMovePiece<PIECE_TYPE_CANNON>(Piece* piece, const PieceArray& pieces, int dest)
+bool legalMovePiece<PIECE_TYPE_CANNON>(const Position& position, int pos, int dest)
 {
-	int offset = get_offset(piece->pos(), dest);
-	if (offset == 0) return false;
-	int curPos = piece->pos() + offset;
-	while (curPos != dest && !pieces[curPos])
+	const SlideMask* slide = nullptr;
+	int bit = 0;
+	if (same_row(pos, dest))
 	{
-		curPos += offset;
+		slide = &rank_slide(position, pos);
+		bit = 1 << (dest & 15);
 	}
-	if (curPos == dest)
+	else if (same_col(pos, dest))
 	{
-			return !pieces[dest];
+		slide = &file_slide(position, pos);
+		bit = 1 << (dest >> 4);
 	}
 	else
 	{
-		curPos += offset;
-		while (curPos != dest && !pieces[curPos])
-		{
-			curPos += offset;
-		}
-		return curPos == dest && piece->oppSide(pieces[dest]);
+		return false;
 	}
+
+	if (slide->nonCap & bit)
+		return true;
+	int oppTag = opp_side_tag(side_of_piece(position.pieceAt(pos)));
+	return (slide->cannonCap & bit) && (position.pieceAt(dest) & oppTag);
 }
 
 template <>
-bool legalMovePiece<PIECE_TYPE_PAWN>(Piece* piece, const PieceArray& pieces, int dest)
+bool legalMovePiece<PIECE_TYPE_PAWN>(const Position& position, int pos, int dest)
 {
-	if (!same_half(piece->sidePlayer()->kingPiece()->pos(), piece->pos()) && 
-			(piece->pos() + 1 == dest || piece->pos() - 1 == dest))
+	int pc = position.pieceAt(pos);
+	if (position.crossedRiver(pc) && (pos + 1 == dest || pos - 1 == dest))
 	{
 		return true;
 	}
-	return dest == piece->forwardStep();
+	return dest == position.forwardStep(pc);
 }
 
-template <>
-int generateMoves<PIECE_TYPE_KING, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs)
+// 以下生成函数的下棋方us在编译期确定，棋子标记和兵(卒)的方向都是常量。
+// mgt为CAPTURE时终点必须是对方棋子，否则终点不能是己方棋子
+template <MoveGenerateType mgt, SideType us>
+inline static bool accept_dest(const Position& position, int dest)
+{
+	return mgt == CAPTURE ?
+		(position.pieceAt(dest) & opp_side_tag(us)) != 0 :
+		!(position.pieceAt(dest) & side_tag(us));
+}
+
+template <MoveGenerateType mgt, SideType us>
+inline static void generate_king_moves(const Position& position, int pos, MoveList& list)
 {
-	int nums = 0;
 	// 九宫内的走法
 	for (int i = 0; i < 4; ++i)
 	{
-		int dest = piece->pos() + array_king_delta[i];
+		int dest = pos + array_king_delta[i];
 		if (!in_fort(dest)) continue;
 
-		if (!piece->sameSide(pieces[dest]))
+		if (accept_dest<mgt, us>(position, dest))
 		{
-			mvs[nums++] = get_move(piece->pos(), dest);
+			list.add(pos, dest, position.mvvLva(PIECE_TYPE_KING, dest));
 		}
 	}
-	return nums;
 }
 
-template <>
-int generateMoves<PIECE_TYPE_ADVISOR, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs)
+template <MoveGenerateType mgt, SideType us>
+inline static void generate_advisor_moves(const Position& position, int pos, MoveList& list)
 {
-	int nums = 0;
 	for (int i = 0; i < 4; ++i)
 	{
-		int dest = piece->pos() + array_advisor_delta[i];
+		int dest = pos + array_advisor_delta[i];
 		if (!in_fort(dest)) continue;
 
-		if (!piece->sameSide(pieces[dest]))
+		if (accept_dest<mgt, us>(position, dest))
 		{
-			mvs[nums++] = get_move(piece->pos(), dest);
+			list.add(pos, dest, position.mvvLva(PIECE_TYPE_ADVISOR, dest));
 		}
 	}
-	return nums;
 }
 
-template <>
-int generateMoves<PIECE_TYPE_BISHOP, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs)
+template <MoveGenerateType mgt, SideType us>
+inline static void generate_bishop_moves(const Position& position, int pos, MoveList& list)
 {
-	int nums = 0;
 	for (int i = 0; i < 4; ++i)
 	{
-		int dest = piece->pos() + array_advisor_delta[i];
+		int dest = pos + array_advisor_delta[i];
 
-		if (!in_board(dest) || 
-				!same_half(piece->pos(), dest) || 
-				pieces[dest])
+		if (!in_board(dest) ||
+				!same_half(pos, dest) ||
+				position.pieceAt(dest))
 		{
 			continue;
 		}
 
 		dest += array_advisor_delta[i];
-		
-		if (!piece->sameSide(pieces[dest]))
+
+		if (accept_dest<mgt, us>(position, dest))
 		{
-			mvs[nums++] = get_move(piece->pos(), dest);
+			list.add(pos, dest, position.mvvLva(PIECE_TYPE_BISHOP, dest));
 		}
 	}
-	return nums;
 }
 
-template <>
-int generateMoves<PIECE_TYPE_KNIGHT, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs)
+template <MoveGenerateType mgt, SideType us>
+inline static void generate_knight_moves(const Position& position, int pos, MoveList& list)
 {
-	int nums = 0;
 	for (int i = 0; i < 4; ++i)
 	{
-		int dest = piece->pos() + array_king_delta[i];
-		if (pieces[dest]) continue;
+		int dest = pos + array_king_delta[i];
+		if (position.pieceAt(dest)) continue;
 
 		for (int j = 0; j < 2; ++j)
 		{
-			dest = piece->pos() + array_knight_delta[i][j];
+			dest = pos + array_knight_delta[i][j];
 			if (!in_board(dest)) continue;
 
-			if (!piece->sameSide(pieces[dest]))
+			if (accept_dest<mgt, us>(position, dest))
 			{
-				mvs[nums++] = get_move(piece->pos(), dest);
+				list.add(pos, dest, position.mvvLva(PIECE_TYPE_KNIGHT, dest));
 			}
 		}
 	}
-	return nums;
 }
 
-template <>
-int generateMoves<PIECE_TYPE_ROOK, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs)
+// 车、炮：不吃子的走法相同，吃子时车吃两侧第一个棋子，炮隔一个棋子吃
+template <PieceType pt, MoveGenerateType mgt, SideType us>
+inline static void generate_slide_moves(const Position& position, int pos, MoveList& list)
 {
-	int nums = 0;
-	for (int i = 0; i < 4; ++i)
+	const SlideMask& rank = rank_slide(position, pos);
+	const SlideMask& file = file_slide(position, pos);
+	if (mgt == GENERAL)
 	{
-		int nDelta = array_king_delta[i];
-		int dest = piece->pos() + nDelta;
-		while (in_board(dest) && !pieces[dest])
-		{
-			mvs[nums++] = get_move(piece->pos(), dest);
-			dest += nDelta;
-		}
-		if (piece->oppSide(pieces[dest]))
-		{
-			mvs[nums++] = get_move(piece->pos(), dest);
-		}
+		rank_mask_moves(position, pt, pos, rank.nonCap, 0, list);
+		file_mask_moves(position, pt, pos, file.nonCap, 0, list);
 	}
-	return nums;
+	int rankCap = pt == PIECE_TYPE_ROOK ? rank.rookCap : rank.cannonCap;
+	int fileCap = pt == PIECE_TYPE_ROOK ? file.rookCap : file.cannonCap;
+	rank_mask_moves(position, pt, pos, rankCap, opp_side_tag(us), list);
+	file_mask_moves(position, pt, pos, fileCap, opp_side_tag(us), list);
 }
 
-template <>
-int generateMoves<PIECE_TYPE_CANNON, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs)
+template <MoveGenerateType mgt, SideType us>
+inline static void generate_pawn_moves(const Position& position, int pos, MoveList& list)
 {
-	int nums = 0;
-	for (int i = 0; i < 4; ++i)
+	int dest = pos + pawn_forward_delta(us);
+	if (in_board(dest) && accept_dest<mgt, us>(position, dest))
 	{
-		int nDelta = array_king_delta[i];
-		int dest = piece->pos() + nDelta;
-		while (in_board(dest))
-		{
-			if (!pieces[dest])
-			{
-				mvs[nums++] = get_move(piece->pos(), dest);
-			}
-			else break;
-
-			dest += nDelta;
-		}
-		dest += nDelta;
-		while (in_board(dest))
-		{
-			if (!pieces[dest]) dest += nDelta;
-			else
-			{
-				if (piece->oppSide(pieces[dest]))
-				{
-					mvs[nums++] = get_move(piece->pos(), dest);
-				}
-				break;
-			}
-		}
-	}
-	return nums;
-}
-
-template <>
-int generateMoves<PIECE_TYPE_PAWN, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs)
-{
-	int nums = 0;
-	int dest = piece->forwardStep();
-	if (in_board(dest))
-	{
-		// capatured move
-		if (!piece->sameSide(pieces[dest]))
-		{
-			mvs[nums++] = get_move(piece->pos(), dest);
-		}
+		list.add(pos, dest, position.mvvLva(PIECE_TYPE_PAWN, dest));
 	}
 
 	// 过河兵
-	if (!same_half(piece->sidePlayer()->kingPiece()->pos(), piece->pos()))
+	if (pawn_crossed_river(us, pos))
 	{
 		for (int nDelta = -1; nDelta <= 1; nDelta += 2)
 		{
-			dest = piece->pos() + nDelta;
+			dest = pos + nDelta;
 
 			if (!in_board(dest)) continue;
 
-			// capatured move
-			if (!piece->sameSide(pieces[dest]))
+			if (accept_dest<mgt, us>(position, dest))
 			{
-				mvs[nums++] = get_move(piece->pos(), dest);
+				list.add(pos, dest, position.mvvLva(PIECE_TYPE_PAWN, dest));
 			}
 		}
 	}
-	return nums;
 }
 
-template <>
-int generateMoves<PIECE_TYPE_KING, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs)
+template <PieceType pt, MoveGenerateType mgt, SideType us>
+inline static void generate_piece_moves(const Position& position, int pos, MoveList& list)
 {
-	int nums = 0;
-	// 九宫内的走法
-	for (int i = 0; i < 4; ++i)
+	switch (pt)
 	{
-		int dest = piece->pos() + array_king_delta[i];
-		if (!in_fort(dest)) continue;
-
-		if (piece->oppSide(pieces[dest]))
-		{
-			mvs[nums++] = get_move(piece->pos(), dest);
-		}
+		case PIECE_TYPE_KING: generate_king_moves<mgt, us>(position, pos, list); break;
+		case PIECE_TYPE_ADVISOR: generate_advisor_moves<mgt, us>(position, pos, list); break;
+		case PIECE_TYPE_BISHOP: generate_bishop_moves<mgt, us>(position, pos, list); break;
+		case PIECE_TYPE_KNIGHT: generate_knight_moves<mgt, us>(position, pos, list); break;
+		case PIECE_TYPE_ROOK:
+		case PIECE_TYPE_CANNON: generate_slide_moves<pt, mgt, us>(position, pos, list); break;
+		case PIECE_TYPE_PAWN: generate_pawn_moves<mgt, us>(position, pos, list); break;
+		default: break;
 	}
-	return nums;
 }
 
-template <>
-int generateMoves<PIECE_TYPE_ADVISOR, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs)
+template <PieceType pt, MoveGenerateType mgt>
+void generateMoves(const Position& position, int pos, MoveList& list)
 {
-	int nums = 0;
-	for (int i = 0; i < 4; ++i)
-	{
-		int dest = piece->pos() + array_advisor_delta[i];
-		if (!in_fort(dest)) continue;
-
-		if (piece->oppSide(pieces[dest]))
-		{
-			mvs[nums++] = get_move(piece->pos(), dest);
-		}
-	}
-	return nums;
+	if (side_of_piece(position.pieceAt(pos)) == SIDE_TYPE_RED)
+		generate_piece_moves<pt, mgt, SIDE_TYPE_RED>(position, pos, list);
+	else
+		generate_piece_moves<pt, mgt, SIDE_TYPE_BLACK>(position, pos, list);
 }
-
-template <>
-int generateMoves<PIECE_TYPE_BISHOP, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs)
+template void generateMoves<PIECE_TYPE_KING, GENERAL>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_ADVISOR, GENERAL>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_BISHOP, GENERAL>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_KNIGHT, GENERAL>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_ROOK, GENERAL>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_CANNON, GENERAL>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_PAWN, GENERAL>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_KING, CAPTURE>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_ADVISOR, CAPTURE>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_BISHOP, CAPTURE>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_KNIGHT, CAPTURE>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_ROOK, CAPTURE>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_CANNON, CAPTURE>(const Position& position, int pos, MoveList& list);
+template void generateMoves<PIECE_TYPE_PAWN, CAPTURE>(const Position& position, int pos, MoveList& list);
+
+// 生成us方pt类所有棋子的走法，棋子类型和下棋方都在编译期确定，可以直接内联对应的生成函数
+template <PieceType pt, MoveGenerateType mgt, SideType us>
+inline static void generate_type_moves(const Position& position, MoveList& list)
 {
-	int nums = 0;
-	for (int i = 0; i < 4; ++i)
+	const uint8_t* pieces = position.pieceList(us, pt);
+	int count = position.pieceCount(us, pt);
+	for (int i = 0; i < count; ++i)
 	{
-		int dest = piece->pos() + array_advisor_delta[i];
-
-		if (!in_board(dest) || 
-				!same_half(piece->pos(), dest) || 
-				pieces[dest])
-		{
-			continue;
-		}
-
-		dest += array_advisor_delta[i];
-
-		if (piece->oppSide(pieces[dest]))
-		{
-			mvs[nums++] = get_move(piece->pos(), dest);
-		}
+		generate_piece_moves<pt, mgt, us>(position, position.piecePos(pieces[i]), list);
 	}
-	return nums;
 }
 
-template <>
-int generateMoves<PIECE_TYPE_KNIGHT, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs)
+template <MoveGenerateType mgt, SideType us>
+__attribute__((flatten)) void generateSideMoves(const Position& position, MoveList& list)
 {
-	int nums = 0;
-	for (int i = 0; i < 4; ++i)
-	{
-		int dest = piece->pos() + array_king_delta[i];
-		if (pieces[dest]) continue;
-
-		for (int j = 0; j < 2; ++j)
-		{
-			dest = piece->pos() + array_knight_delta[i][j];
-			if (!in_board(dest)) continue;
-
-			if (piece->oppSide(pieces[dest]))
-			{
-				mvs[nums++] = get_move(piece->pos(), dest);
-			}
-		}
-	}
-	return nums;
+	generate_type_moves<PIECE_TYPE_KING, mgt, us>(position, list);
+	generate_type_moves<PIECE_TYPE_ADVISOR, mgt, us>(position, list);
+	generate_type_moves<PIECE_TYPE_BISHOP, mgt, us>(position, list);
+	generate_type_moves<PIECE_TYPE_KNIGHT, mgt, us>(position, list);
+	generate_type_moves<PIECE_TYPE_ROOK, mgt, us>(position, list);
+	generate_type_moves<PIECE_TYPE_CANNON, mgt, us>(position, list);
+	generate_type_moves<PIECE_TYPE_PAWN, mgt, us>(position, list);
 }
+template void generateSideMoves<GENERAL, SIDE_TYPE_RED>(const Position& position, MoveList& list);
+template void generateSideMoves<GENERAL, SIDE_TYPE_BLACK>(const Position& position, MoveList& list);
+template void generateSideMoves<CAPTURE, SIDE_TYPE_RED>(const Position& position, MoveList& list);
+template void generateSideMoves<CAPTURE, SIDE_TYPE_BLACK>(const Position& position, MoveList& list);
 
-template <>
-int generateMoves<PIECE_TYPE_ROOK, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs)
+template <MoveGenerateType mgt>
+void generateSideMoves(const Position& position, int side, MoveList& list)
 {
-	int nums = 0;
-	for (int i = 0; i < 4; ++i)
-	{
-		int nDelta = array_king_delta[i];
-		int dest = piece->pos() + nDelta;
-		while (in_board(dest) && !pieces[dest])
-		{
-			dest += nDelta;
-		}
-		if (piece->oppSide(pieces[dest]))
-		{
-			mvs[nums++] = get_move(piece->pos(), dest);
-		}
-	}
-	return nums;
+	if (side == SIDE_TYPE_RED)
+		generateSideMoves<mgt, SIDE_TYPE_RED>(position, list);
+	else
+		generateSideMoves<mgt, SIDE_TYPE_BLACK>(position, list);
 }
+template void generateSideMoves<GENERAL>(const Position& position, int side, MoveList& list);
+template void generateSideMoves<CAPTURE>(const Position& position, int side, MoveList& list);
 
-template <>
-int generateMoves<PIECE_TYPE_CANNON, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs)
+template <MoveGenerateType mgt>
+void generateMovesByType(const Position& position, int type, int pos, MoveList& list)
 {
-	int nums = 0;
-	for (int i = 0; i < 4; ++i)
+	switch (type)
 	{
-		int nDelta = array_king_delta[i];
-		int dest = piece->pos() + nDelta;
-		while (in_board(dest) && !pieces[dest])
-		{
-			dest += nDelta;
-		}
-		dest += nDelta;
-		while (in_board(dest) && !pieces[dest])
-		{
-			dest += nDelta;
-		}
-		if (piece->oppSide(pieces[dest]))
-		{
-			mvs[nums++] = get_move(piece->pos(), dest);
-		}
+		case PIECE_TYPE_KING: generateMoves<PIECE_TYPE_KING, mgt>(position, pos, list); break;
+		case PIECE_TYPE_ADVISOR: generateMoves<PIECE_TYPE_ADVISOR, mgt>(position, pos, list); break;
+		case PIECE_TYPE_BISHOP: generateMoves<PIECE_TYPE_BISHOP, mgt>(position, pos, list); break;
+		case PIECE_TYPE_KNIGHT: generateMoves<PIECE_TYPE_KNIGHT, mgt>(position, pos, list); break;
+		case PIECE_TYPE_ROOK: generateMoves<PIECE_TYPE_ROOK, mgt>(position, pos, list); break;
+		case PIECE_TYPE_CANNON: generateMoves<PIECE_TYPE_CANNON, mgt>(position, pos, list); break;
+		case PIECE_TYPE_PAWN: generateMoves<PIECE_TYPE_PAWN, mgt>(position, pos, list); break;
+		default: break;
 	}
-	return nums;
 }
+template void generateMovesByType<GENERAL>(const Position& position, int type, int pos, MoveList& list);
+template void generateMovesByType<CAPTURE>(const Position& position, int type, int pos, MoveList& list);
 
-template <>
-int generateMoves<PIECE_TYPE_PAWN, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs)
+bool legalMoveByType(const Position& position, int type, int pos, int dest)
 {
-	int nums = 0;
-	int dest = piece->forwardStep();
-	if (in_board(dest))
-	{
-		// capatured move
-		if (piece->oppSide(pieces[dest]))
-		{
-			mvs[nums++] = get_move(piece->pos(), dest);
-		}
-	}
-
-	// 过河兵
-	if (!same_half(piece->sidePlayer()->kingPiece()->pos(), piece->pos()))
+	switch (type)
 	{
-		for (int nDelta = -1; nDelta <= 1; nDelta += 2)
-		{
-			dest = piece->pos() + nDelta;
-
-			if (!in_board(dest)) continue;
-
-			// capatured move
-			if (piece->oppSide(pieces[dest]))
-			{
-				mvs[nums++] = get_move(piece->pos(), dest);
-			}
-		}
+		case PIECE_TYPE_KING: return legalMovePiece<PIECE_TYPE_KING>(position, pos, dest);
+		case PIECE_TYPE_ADVISOR: return legalMovePiece<PIECE_TYPE_ADVISOR>(position, pos, dest);
+		case PIECE_TYPE_BISHOP: return legalMovePiece<PIECE_TYPE_BISHOP>(position, pos, dest);
+		case PIECE_TYPE_KNIGHT: return legalMovePiece<PIECE_TYPE_KNIGHT>(position, pos, dest);
+		case PIECE_TYPE_ROOK: return legalMovePiece<PIECE_TYPE_ROOK>(position, pos, dest);
+		case PIECE_TYPE_CANNON: return legalMovePiece<PIECE_TYPE_CANNON>(position, pos, dest);
+		case PIECE_TYPE_PAWN: return legalMovePiece<PIECE_TYPE_PAWN>(position, pos, dest);
+		default: return false;
 	}
-	return nums;
 }
 
 }
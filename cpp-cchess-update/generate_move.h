@@ -1,6 +1,9 @@
 #ifndef __WSUN_CCHESS_CPP_UPDATE_GENERATE_MOVE_H__
 #define __WSUN_CCHESS_CPP_UPDATE_GENERATE_MOVE_H__
 
+#include <inttypes.h>
+#include <algorithm>
+#include <climits>
 #include "utils.h"
 
 namespace wsun
@@ -10,74 +13,141 @@ namespace cchess
 namespace cppupdate
 {
 
-template <PieceType pt>
-bool legalMovePiece(Piece* piece, const PieceArray& pieces, int dest);
-
-template <>
-bool legalMovePiece<PIECE_TYPE_KING>(Piece* piece, const PieceArray& pieces, int dest);
+class Position;
 
-template <>
-bool legalMovePiece<PIECE_TYPE_ADVISOR>(Piece* piece, const PieceArray& pieces, int dest);
+#define MAX_GENERATE_MOVES 128
 
-template <>
-bool legalMovePiece<PIECE_TYPE_BISHOP>(Piece* piece, const PieceArray& pieces, int dest);
-
-template <>
-bool legalMovePiece<PIECE_TYPE_KNIGHT>(Piece* piece, const PieceArray& pieces, int dest);
-
-template <>
-bool legalMovePiece<PIECE_TYPE_ROOK>(Piece* piece, const PieceArray& pieces, int dest);
-
-template <>
-bool legalMovePiece<PIECE_TYPE_CANNON>(Piece* piece, const PieceArray& pieces, int dest);
+// 带排序分值的走法
+struct ScoredMove
+{
+	Move move;
+	int score;
+};
 
-template <>
-bool legalMovePiece<PIECE_TYPE_PAWN>(Piece* piece, const PieceArray& pieces, int dest);
+// 走法列表，生成走法时同时打分：
+// 设置了历史表则按历史表打分，否则吃子走法按MVV/LVA打分，不吃子走法为0
+struct MoveList
+{
+	MoveList(const int* historyTable = nullptr) : size(0), history(historyTable) {}
+
+	void add(int start, int end, int mvvLva)
+	{
+		Move mv(start, end);
+		moves[size].move = mv;
+		moves[size].score = history ? history[mv.value()] : mvvLva;
+		++size;
+	}
+
+	// 按分值从高到低排序
+	void sort()
+	{
+		std::sort(moves, moves + size, [](const ScoredMove& left, const ScoredMove& right)
+				{
+					return right.score < left.score;
+				});
+	}
+
+	// 把[i, size)中分值最高的走法换到第i个位置，适合只用到前面几个走法的场合
+	void pickBest(int i)
+	{
+		int best = i;
+		for (int j = i + 1; j < size; ++j)
+		{
+			if (moves[j].score > moves[best].score)
+				best = j;
+		}
+		if (best != i)
+			std::swap(moves[i], moves[best]);
+	}
+
+	// 把mv的分值提到最高(例如置换表走法)，不在列表中返回false
+	bool prefer(Move mv)
+	{
+		for (int i = 0; i < size; ++i)
+		{
+			if (moves[i].move == mv)
+			{
+				moves[i].score = INT_MAX;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool contains(Move mv) const
+	{
+		for (int i = 0; i < size; ++i)
+		{
+			if (moves[i].move == mv)
+				return true;
+		}
+		return false;
+	}
+
+	ScoredMove moves[MAX_GENERATE_MOVES];
+	int size;
+	const int* history;
+};
+
+// 车、炮在一行(列)上的走法，位掩码按16x16棋盘上的横(纵)坐标置位
+struct SlideMask
+{
+	uint16_t nonCap;			// 不吃子能走到的位置
+	uint16_t rookCap;			// 车能吃到的位置(两侧第一个棋子)
+	uint16_t cannonCap;		// 炮能吃到的位置(两侧隔一个棋子的第一个棋子)
+};
 
-template <PieceType pt, MoveGenerateType mgt>
-int generateMoves(Piece* piece, const PieceArray& pieces, int* mvs);
+// 以(在行(列)中的位置, 该行(列)的占位)为索引的滑动走法表，编译期生成
+struct SlideTables
+{
+	SlideMask rank[9][1 << 9];
+	SlideMask file[10][1 << 10];
+};
 
-template <>
-int generateMoves<PIECE_TYPE_KING, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs);
+extern const SlideTables slide_tables;
 
-template <>
-int generateMoves<PIECE_TYPE_ADVISOR, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs);
+// 按棋子类型分组生成us方所有棋子的走法，下棋方在编译期确定，
+// 棋子标记、兵(卒)的方向和过河判断都是常量
+template <MoveGenerateType mgt, SideType us>
+void generateSideMoves(const Position& position, MoveList& list);
 
-template <>
-int generateMoves<PIECE_TYPE_BISHOP, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs);
+// 运行期的side分派到上面的版本
+template <MoveGenerateType mgt>
+void generateSideMoves(const Position& position, int side, MoveList& list);
 
-template <>
-int generateMoves<PIECE_TYPE_KNIGHT, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs);
+// 按运行期的棋子类型分派的走法生成和走法判断，只用于单个棋子，不在走法生成的热点路径上
+template <MoveGenerateType mgt>
+void generateMovesByType(const Position& position, int type, int pos, MoveList& list);
 
-template <>
-int generateMoves<PIECE_TYPE_ROOK, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs);
+bool legalMoveByType(const Position& position, int type, int pos, int dest);
 
-template <>
-int generateMoves<PIECE_TYPE_CANNON, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs);
+template <PieceType pt>
+bool legalMovePiece(const Position& position, int pos, int dest);
 
 template <>
-int generateMoves<PIECE_TYPE_PAWN, GENERAL>(Piece* piece, const PieceArray& pieces, int* mvs);
+bool legalMovePiece<PIECE_TYPE_KING>(const Position& position, int pos, int dest);
 
 template <>
-int generateMoves<PIECE_TYPE_KING, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs);
+bool legalMovePiece<PIECE_TYPE_ADVISOR>(const Position& position, int pos, int dest);
 
 template <>
-int generateMoves<PIECE_TYPE_ADVISOR, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs);
+bool legalMovePiece<PIECE_TYPE_BISHOP>(const Position& position, int pos, int dest);
 
 template <>
-int generateMoves<PIECE_TYPE_BISHOP, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs);
+bool legalMovePiece<PIECE_TYPE_KNIGHT>(const Position& position, int pos, int dest);
 
 template <>
-int generateMoves<PIECE_TYPE_KNIGHT, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs);
+bool legalMovePiece<PIECE_TYPE_ROOK>(const Position& position, int pos, int dest);
 
 template <>
-int generateMoves<PIECE_TYPE_ROOK, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs);
+bool legalMovePiece<PIECE_TYPE_CANNON>(const Position& position, int pos, int dest);
 
 template <>
-int generateMoves<PIECE_TYPE_CANNON, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs);
+bool legalMovePiece<PIECE_TYPE_PAWN>(const Position& position, int pos, int dest);
 
-template <>
-int generateMoves<PIECE_TYPE_PAWN, CAPTURE>(Piece* piece, const PieceArray& pieces, int* mvs);
+// 生成pos处棋子的走法，下棋方由棋子决定
+template <PieceType pt, MoveGenerateType mgt>
+void generateMoves(const Position& position, int pos, MoveList& list);
 
 }
 }
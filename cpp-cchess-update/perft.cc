@@ -0,0 +1,141 @@
+#include "perft.h"
+#include <thread>
+
+namespace wsun
+{
+namespace cchess
+{
+namespace cppupdate
+{
+
+const PerftPosition perft_positions[] = {
+	{ "rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR w", { 44, 1920, 79666, 3290240, 133312995 } },
+	{ "r1ba1a3/4kn3/2n1b4/pNp1p1p1p/4c4/6P2/P1P2R2P/1CcC5/9/2BAKAB2 w", { 38, 1128, 43929, 1339047, 53112976 } },
+	{ "1cbak4/9/n2a5/2p1p3p/5cp2/2n2N3/6PCP/3AB4/2C6/3A1K1N1 w", { 7, 281, 8620, 326201, 10369923 } },
+	{ "5a3/3k5/3aR4/9/5r3/5n3/9/3A1A3/5K3/2BC2B2 w", { 25, 424, 9850, 202884, 4739553 } },
+};
+const int perft_positions_size = sizeof(perft_positions) / sizeof(perft_positions[0]);
+
+PerftHash::PerftHash(size_t megabytes)
+{
+	// 条目数取不超过megabytes的2的幂
+	size_t count = 1;
+	while (count * 2 * sizeof(Entry) <= (megabytes << 20))
+		count <<= 1;
+	entries_ = std::vector<Entry>(count);
+}
+
+bool PerftHash::probe(uint64_t key, int depth, uint64_t* nodes) const
+{
+	const Entry& entry = entries_[key & (entries_.size() - 1)];
+	uint64_t data = entry.data.load(std::memory_order_relaxed);
+	uint64_t check = entry.check.load(std::memory_order_relaxed);
+	if ((check ^ data) != key || (int)(data & 0xff) != depth)
+		return false;
+	*nodes = data >> 8;
+	return true;
+}
+
+void PerftHash::store(uint64_t key, int depth, uint64_t nodes)
+{
+	Entry& entry = entries_[key & (entries_.size() - 1)];
+	uint64_t data = (nodes << 8) | (uint64_t)depth;
+	entry.check.store(key ^ data, std::memory_order_relaxed);
+	entry.data.store(data, std::memory_order_relaxed);
+}
+
+void PerftHash::clear()
+{
+	for (Entry& entry : entries_)
+	{
+		entry.check.store(0, std::memory_order_relaxed);
+		entry.data.store(0, std::memory_order_relaxed);
+	}
+}
+
+static uint64_t perft_nodes(Board& board, int depth, PerftHash* hash)
+{
+	uint64_t key = board.getZobrist().key_;
+	uint64_t nodes = 0;
+	if (hash && depth > 1 && hash->probe(key, depth, &nodes))
+		return nodes;
+
+	MoveList list;
+	int n = board.generateAllMovesNoncheck<GENERAL>(list);
+	if (depth == 1)
+		return n;
+
+	for (int i = 0; i < n; ++i)
+	{
+		board.makeMove(list.moves[i].move);
+		board.changeSide();
+		nodes += perft_nodes(board, depth - 1, hash);
+		board.undoMove();
+		board.changeSide();
+	}
+
+	if (hash)
+		hash->store(key, depth, nodes);
+	return nodes;
+}
+
+uint64_t perft(Board& board, int depth, PerftHash* hash)
+{
+	return depth <= 0 ? 1 : perft_nodes(board, depth, hash);
+}
+
+uint64_t perftDivide(Board& board, int depth, std::vector<PerftDivide>& divide,
+		int threads, PerftHash* hash)
+{
+	divide.clear();
+	if (depth <= 0)
+		return 1;
+
+	MoveList list;
+	int n = board.generateAllMovesNoncheck<GENERAL>(list);
+	for (int i = 0; i < n; ++i)
+		divide.push_back({ list.moves[i].move, 1 });
+
+	if (depth > 1)
+	{
+		char fen[MAX_FEN_LENGTH];
+		board.toFen(fen, MAX_FEN_LENGTH);
+		std::atomic<int> next(0);
+		auto worker = [&](Board& local)
+		{
+			int i;
+			while ((i = next.fetch_add(1)) < n)
+			{
+				local.makeMove(divide[i].mv);
+				local.changeSide();
+				divide[i].nodes = perft_nodes(local, depth - 1, hash);
+				local.undoMove();
+				local.changeSide();
+			}
+		};
+
+		threads = std::max(1, std::min(threads, n));
+		std::vector<std::thread> helpers;
+		for (int t = 1; t < threads; ++t)
+		{
+			helpers.emplace_back([&]()
+					{
+						Board local;
+						local.resetFromFen(fen);
+						worker(local);
+					});
+		}
+		worker(board);
+		for (std::thread& helper : helpers)
+			helper.join();
+	}
+
+	uint64_t nodes = 0;
+	for (const PerftDivide& item : divide)
+		nodes += item.nodes;
+	return nodes;
+}
+
+} // namespace cppupdate
+} // namespace cchess
+} // namespace wsun
@@ -0,0 +1,75 @@
+#ifndef __WSUN_CCHESS_CPP_UPDATE_PERFT_H__
+#define __WSUN_CCHESS_CPP_UPDATE_PERFT_H__
+
+#include "board.h"
+#include <atomic>
+#include <vector>
+#include <inttypes.h>
+#include <stddef.h>
+
+namespace wsun
+{
+namespace cchess
+{
+namespace cppupdate
+{
+
+// perft：从当前局面出发走depth步的叶子节点数，用来校验合法走法生成器，
+// 也可以当作走法生成的吞吐量测试。最后一层只数合法走法的个数，不再逐个走棋
+
+// perft置换表，按zobrist和剩余深度缓存子树的节点数。
+// 多个线程共享，无锁：校验值为key与数据的异或，读到被其他线程写了一半的条目时校验不通过
+class PerftHash
+{
+public:
+	explicit PerftHash(size_t megabytes);
+
+	PerftHash(const PerftHash&) = delete;
+	PerftHash& operator=(const PerftHash&) = delete;
+
+	bool probe(uint64_t key, int depth, uint64_t* nodes) const;
+	void store(uint64_t key, int depth, uint64_t nodes);
+	void clear();
+	size_t size() const { return entries_.size(); }
+
+private:
+	struct Entry
+	{
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data;		// 高56位为节点数，低8位为剩余深度
+	};
+
+	std::vector<Entry> entries_;
+};
+
+// 根节点上每个走法的子树叶子节点数
+struct PerftDivide
+{
+	Move mv;
+	uint64_t nodes;
+};
+
+// 已知节点数的局面，nodes[i]为深度i + 1的节点数
+struct PerftPosition
+{
+	const char* fen;
+	uint64_t nodes[5];
+};
+
+// 标准开局局面以及几个公开发表过节点数的中残局局面，可以作为走法生成器的校验基准
+extern const PerftPosition perft_positions[];
+extern const int perft_positions_size;
+
+// hash为空则不使用置换表
+uint64_t perft(Board& board, int depth, PerftHash* hash = nullptr);
+
+// 分别统计每个根走法，threads个线程从根走法中轮流领取，返回总节点数。
+// 除了调用线程使用board之外，其他线程各自按board的fen串建一个棋盘
+uint64_t perftDivide(Board& board, int depth, std::vector<PerftDivide>& divide,
+		int threads = 1, PerftHash* hash = nullptr);
+
+} // namespace cppupdate
+} // namespace cchess
+} // namespace wsun
+
+#endif // __WSUN_CCHESS_CPP_UPDATE_PERFT_H__
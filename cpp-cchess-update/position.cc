@@ -0,0 +1,601 @@
+#include "position.h"
+#include "generate_move.h"
+
+namespace wsun
+{
+namespace cchess
+{
+namespace cppupdate
+{
+
+// 帅(将)斜向相邻的位置(即攻击它的马的马腿)在array_advisor_delta中的下标，不相邻返回-1
+inline static int knight_leg_index(int kingPos, int pos)
+{
+	switch (pos - kingPos)
+	{
+		case -17: return 0;
+		case -15: return 1;
+		case 15: return 2;
+		case 17: return 3;
+		default: return -1;
+	}
+}
+
+#ifdef CCHESS_ATTACK_MAPS
+// a、b在同一行(列)时，两者之间的棋子数
+inline static int pieces_between(int bits, int a, int b)
+{
+	int low = a < b ? a : b;
+	int high = a < b ? b : a;
+	return __builtin_popcount(bits & ((1 << high) - (1 << (low + 1))));
+}
+
+uint32_t Position::attackDependents(int pos) const
+{
+	// 沿线攻击的棋子与pos之间的棋子数不超过screens才会受影响：
+	// 车和帅(将)照面不能隔子，炮可以隔一个炮架
+	static constexpr int line_types[3] = { PIECE_TYPE_KING, PIECE_TYPE_ROOK, PIECE_TYPE_CANNON };
+	uint32_t slots = 0;
+	for (int side = 0; side < 2; ++side)
+	{
+		for (int type : line_types)
+		{
+			int screens = type == PIECE_TYPE_CANNON ? 1 : 0;
+			for (int i = 0; i < pieceCount_[side][type]; ++i)
+			{
+				int pc = pieceList_[side][type][i];
+				int p = slotPos_[pc - 16];
+				if (p == pos)
+					continue;
+				if (same_col(p, pos))
+				{
+					if (pieces_between(fileBits(p), p >> 4, pos >> 4) <= screens)
+						slots |= 1u << (pc - 16);
+				}
+				else if (same_row(p, pos) && type != PIECE_TYPE_KING)
+				{
+					if (pieces_between(rankBits(p), p & 15, pos & 15) <= screens)
+						slots |= 1u << (pc - 16);
+				}
+			}
+		}
+	}
+
+	for (int i = 0; i < 4; ++i)
+	{
+		// pos是马腿：马与pos横竖相邻
+		int pc = squares_[pos + array_king_delta[i]];
+		if (pc && slotType_[pc - 16] == PIECE_TYPE_KNIGHT)
+			slots |= 1u << (pc - 16);
+		// pos是象眼：相(象)与pos斜向相邻
+		pc = squares_[pos + array_advisor_delta[i]];
+		if (pc && slotType_[pc - 16] == PIECE_TYPE_BISHOP)
+			slots |= 1u << (pc - 16);
+	}
+	return slots;
+}
+
+void Position::toggleAttacks(uint32_t slots)
+{
+	while (slots)
+	{
+		int slot = __builtin_ctz(slots);
+		slots &= slots - 1;
+		int pos = slotPos_[slot];
+		if (!pos)
+			continue;
+
+		uint32_t bit = 1u << slot;
+		int pc = slot + 16;
+		int side = side_of_piece(pc);
+		switch (slotType_[slot])
+		{
+			case PIECE_TYPE_KING:
+			{
+				for (int i = 0; i < 4; ++i)
+				{
+					int dest = pos + array_king_delta[i];
+					if (in_fort(dest))
+						attackers_[dest] ^= bit;
+				}
+				// 帅(将)照面：同一列上相邻的棋子就是对方的帅(将)
+				int oppKing = kingPos(1 - side);
+				if (oppKing && same_col(pos, oppKing))
+				{
+					int delta = oppKing > pos ? 16 : -16;
+					int p = pos + delta;
+					while (!squares_[p])
+						p += delta;
+					if (p == oppKing)
+						attackers_[oppKing] ^= bit;
+				}
+				break;
+			}
+			case PIECE_TYPE_ADVISOR:
+				for (int i = 0; i < 4; ++i)
+				{
+					int dest = pos + array_advisor_delta[i];
+					if (in_fort(dest))
+						attackers_[dest] ^= bit;
+				}
+				break;
+			case PIECE_TYPE_BISHOP:
+				for (int i = 0; i < 4; ++i)
+				{
+					int eye = pos + array_advisor_delta[i];
+					int dest = eye + array_advisor_delta[i];
+					if (in_board(dest) && same_half(pos, dest) && !squares_[eye])
+						attackers_[dest] ^= bit;
+				}
+				break;
+			case PIECE_TYPE_KNIGHT:
+				for (int i = 0; i < 4; ++i)
+				{
+					if (squares_[pos + array_king_delta[i]])
+						continue;
+					for (int j = 0; j < 2; ++j)
+					{
+						int dest = pos + array_knight_delta[i][j];
+						if (in_board(dest))
+							attackers_[dest] ^= bit;
+					}
+				}
+				break;
+			case PIECE_TYPE_ROOK:
+			case PIECE_TYPE_CANNON:
+			{
+				// 车攻击沿线直到第一个棋子(含)，炮攻击炮架之后直到下一个棋子(含)
+				int screens = slotType_[slot] == PIECE_TYPE_ROOK ? 0 : 1;
+				for (int i = 0; i < 4; ++i)
+				{
+					int delta = array_king_delta[i];
+					int found = 0;
+					for (int p = pos + delta; in_board(p); p += delta)
+					{
+						if (found == screens)
+							attackers_[p] ^= bit;
+						if (squares_[p] && ++found > screens)
+							break;
+					}
+				}
+				break;
+			}
+			case PIECE_TYPE_PAWN:
+			{
+				int dest = pos + pawn_forward_delta(side);
+				if (in_board(dest))
+					attackers_[dest] ^= bit;
+				if (pawn_crossed_river(side, pos))
+				{
+					if (in_board(pos - 1))
+						attackers_[pos - 1] ^= bit;
+					if (in_board(pos + 1))
+						attackers_[pos + 1] ^= bit;
+				}
+				break;
+			}
+			default:
+				break;
+		}
+	}
+}
+
+#endif
+
+uint32_t Position::computeAttackers(int pos) const
+{
+	uint32_t slots = 0;
+	int target = squares_[pos];
+	for (int i = 0; i < 4; ++i)
+	{
+		// 车、帅(将)照面：沿线的第一个棋子；炮：沿线的第二个棋子
+		int delta = array_king_delta[i];
+		int p = pos + delta;
+		while (in_board(p) && !squares_[p])
+			p += delta;
+		if (!in_board(p))
+			continue;
+		int pc = squares_[p];
+		int type = slotType_[pc - 16];
+		if (type == PIECE_TYPE_ROOK ||
+				(type == PIECE_TYPE_KING && (delta == 16 || delta == -16) &&
+				 target && slotType_[target - 16] == PIECE_TYPE_KING))
+			slots |= 1u << (pc - 16);
+		for (p += delta; in_board(p) && !squares_[p]; p += delta)
+			;
+		if (in_board(p) && slotType_[squares_[p] - 16] == PIECE_TYPE_CANNON)
+			slots |= 1u << (squares_[p] - 16);
+	}
+
+	for (int i = 0; i < 4; ++i)
+	{
+		int pc;
+		// 马：经过斜向相邻的马腿过来
+		if (!squares_[pos + array_advisor_delta[i]])
+		{
+			for (int j = 0; j < 2; ++j)
+			{
+				pc = squares_[pos + array_knight_check_delta[i][j]];
+				if (pc && slotType_[pc - 16] == PIECE_TYPE_KNIGHT)
+					slots |= 1u << (pc - 16);
+			}
+		}
+		// 相(象)：象眼没有棋子，且在同一边
+		int dest = pos + array_advisor_delta[i] * 2;
+		pc = squares_[dest];
+		if (pc && slotType_[pc - 16] == PIECE_TYPE_BISHOP &&
+				same_half(pos, dest) && !squares_[pos + array_advisor_delta[i]])
+			slots |= 1u << (pc - 16);
+		if (in_fort(pos))
+		{
+			// 仕(士)、帅(将)：只在九宫内攻击
+			pc = squares_[pos + array_advisor_delta[i]];
+			if (pc && slotType_[pc - 16] == PIECE_TYPE_ADVISOR)
+				slots |= 1u << (pc - 16);
+			pc = squares_[pos + array_king_delta[i]];
+			if (pc && slotType_[pc - 16] == PIECE_TYPE_KING)
+				slots |= 1u << (pc - 16);
+		}
+	}
+
+	// 兵(卒)：从正后方，或者过河后从左右两边攻击
+	for (int side = 0; side < 2; ++side)
+	{
+		int pc = squares_[pos - pawn_forward_delta(side)];
+		if ((pc & side_tag(side)) && slotType_[pc - 16] == PIECE_TYPE_PAWN)
+			slots |= 1u << (pc - 16);
+	}
+	for (int delta = -1; delta <= 1; delta += 2)
+	{
+		int pc = squares_[pos + delta];
+		if (pc && slotType_[pc - 16] == PIECE_TYPE_PAWN && crossedRiver(pc))
+			slots |= 1u << (pc - 16);
+	}
+	return slots;
+}
+
+// 静态交换评估中帅(将)的价值，大于双方其他棋子的总和，用帅(将)吃子之后还会被吃就不划算
+static const int SEE_KING_VALUE = 5000;
+
+inline static int see_value(int side, int type, int pos)
+{
+	return type == PIECE_TYPE_KING ? SEE_KING_VALUE : Position::pieceValue(side, type, pos);
+}
+
+int Position::see(int from, int to)
+{
+	int gain[PIECE_SLOTS + 1];
+	uint8_t cleared[PIECE_SLOTS];
+	uint8_t moved[PIECE_SLOTS];
+	int target = squares_[to];
+	int pc = squares_[from];
+	int side = side_of_piece(pc);
+	int d = 0;
+	int n = 0;
+
+	gain[0] = target ? see_value(1 - side, slotType_[target - 16], to) : 0;
+	squares_[from] = 0;
+	squares_[to] = (uint8_t)pc;
+	moved[n] = (uint8_t)pc;
+	cleared[n++] = (uint8_t)from;
+	while (true)
+	{
+		side = 1 - side;
+		uint32_t slots = computeAttackers(to) & side_slots_mask(side);
+		if (!slots)
+			break;
+
+		// 找最便宜的攻击者
+		int attacker = 0;
+		int attackerValue = 0;
+		while (slots)
+		{
+			int slot = __builtin_ctz(slots);
+			slots &= slots - 1;
+			int value = see_value(side, slotType_[slot], to);
+			if (!attacker || value < attackerValue)
+			{
+				attacker = slot + 16;
+				attackerValue = value;
+			}
+		}
+
+		++d;
+		gain[d] = see_value(1 - side, slotType_[pc - 16], to) - gain[d - 1];
+		// 无论是否继续吃，结果的正负都不会再变
+		if (std::max(-gain[d - 1], gain[d]) < 0)
+			break;
+
+		pc = attacker;
+		int pos = slotPos_[pc - 16];
+		squares_[pos] = 0;
+		squares_[to] = (uint8_t)pc;
+		moved[n] = (uint8_t)pc;
+		cleared[n++] = (uint8_t)pos;
+	}
+
+	// 复原棋盘，吃子时只改了squares_，棋子的slotPos_还是原来的位置
+	for (int i = 0; i < n; ++i)
+		squares_[cleared[i]] = moved[i];
+	squares_[to] = (uint8_t)target;
+
+	// 从最后一次兑换往回推，每一方都可以选择不再吃
+	for (; d > 0; --d)
+		gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+	return gain[0];
+}
+
+bool Position::losingCapture(int from, int to)
+{
+	int pc = squares_[from];
+	int target = squares_[to];
+	int side = side_of_piece(pc);
+	if (see_value(1 - side, slotType_[target - 16], to) >= see_value(side, slotType_[pc - 16], to))
+		return false;
+	return see(from, to) < 0;
+}
+
+bool Position::lineChecked(int side, int kingPos, int delta) const
+{
+	int oppTag = opp_side_tag(side);
+	int pos = kingPos + delta;
+	while (in_board(pos) && !squares_[pos])
+	{
+		pos += delta;
+	}
+	if (!in_board(pos))
+		return false;
+
+	// 第一个棋子：车或者帅(将)照面
+	int pc = squares_[pos];
+	if (pc & oppTag)
+	{
+		int type = pieceType(pc);
+		if (type == PIECE_TYPE_ROOK || type == PIECE_TYPE_KING)
+			return true;
+	}
+
+	// 第二个棋子：炮
+	pos += delta;
+	while (in_board(pos) && !squares_[pos])
+	{
+		pos += delta;
+	}
+	if (!in_board(pos))
+		return false;
+	pc = squares_[pos];
+	return (pc & oppTag) && pieceType(pc) == PIECE_TYPE_CANNON;
+}
+
+bool Position::knightChecked(int side, int kingPos, int i) const
+{
+	if (squares_[kingPos + array_advisor_delta[i]])
+		return false;
+
+	int oppTag = opp_side_tag(side);
+	for (int j = 0; j < 2; ++j)
+	{
+		int pc = squares_[kingPos + array_knight_check_delta[i][j]];
+		if ((pc & oppTag) && pieceType(pc) == PIECE_TYPE_KNIGHT)
+			return true;
+	}
+	return false;
+}
+
+bool Position::checked(int side) const
+{
+	int kingPos = this->kingPos(side);
+	if (!kingPos)
+		return false;
+
+	for (int i = 0; i < 4; ++i)
+	{
+		if (lineChecked(side, kingPos, array_king_delta[i]) ||
+				knightChecked(side, kingPos, i))
+			return true;
+	}
+
+	// 兵(卒)：从正前方或者过河后从左右两边攻击
+	int oppSide = 1 - side;
+	int oppTag = opp_side_tag(side);
+	int forward = pawn_forward_delta(oppSide);
+	int pc = squares_[kingPos - forward];
+	if ((pc & oppTag) && pieceType(pc) == PIECE_TYPE_PAWN)
+		return true;
+	for (int delta = -1; delta <= 1; delta += 2)
+	{
+		pc = squares_[kingPos + delta];
+		if ((pc & oppTag) && pieceType(pc) == PIECE_TYPE_PAWN && crossedRiver(pc))
+			return true;
+	}
+	return false;
+}
+
+bool Position::exposedByMove(int side, int from, int to) const
+{
+	int kingPos = this->kingPos(side);
+	if (!kingPos)
+		return false;
+
+	int fromDelta = get_offset(kingPos, from);
+	if (fromDelta && lineChecked(side, kingPos, fromDelta))
+		return true;
+
+	// 走到帅(将)所在的线上，可能成为对方炮的炮架
+	int toDelta = get_offset(kingPos, to);
+	if (toDelta && toDelta != fromDelta && lineChecked(side, kingPos, toDelta))
+		return true;
+
+	int leg = knight_leg_index(kingPos, from);
+	return leg >= 0 && knightChecked(side, kingPos, leg);
+}
+
+bool Position::checkedByMove(int side, int from, int to) const
+{
+	int kingPos = this->kingPos(side);
+	if (!kingPos)
+		return false;
+
+	// 走动的棋子直接将军，车、炮和帅(将)照面在下面沿线检查
+	int pc = squares_[to];
+	int type = pieceType(pc);
+	if (type == PIECE_TYPE_KNIGHT && legalMovePiece<PIECE_TYPE_KNIGHT>(*this, to, kingPos))
+		return true;
+	if (type == PIECE_TYPE_PAWN && legalMovePiece<PIECE_TYPE_PAWN>(*this, to, kingPos))
+		return true;
+
+	int toDelta = get_offset(kingPos, to);
+	if (toDelta && lineChecked(side, kingPos, toDelta))
+		return true;
+
+	// 抽将：离开的位置在帅(将)的线上或者是马腿
+	int fromDelta = get_offset(kingPos, from);
+	if (fromDelta && fromDelta != toDelta && lineChecked(side, kingPos, fromDelta))
+		return true;
+
+	int leg = knight_leg_index(kingPos, from);
+	return leg >= 0 && knightChecked(side, kingPos, leg);
+}
+
+bool Position::checkedAfterMove(int from, int to)
+{
+	ScopedMove move(*this, from, to);
+	return checked(side_of_piece(move.piece()));
+}
+
+bool Position::givesCheck(int from, int to)
+{
+	ScopedMove move(*this, from, to);
+	return checkedByMove(1 - side_of_piece(move.piece()), from, to);
+}
+
+void Position::checkInfo(int side, CheckInfo& info) const
+{
+	memset(&info, 0, sizeof(info));
+	int kingPos = this->kingPos(side);
+	if (!kingPos)
+		return;
+
+	auto addChecker = [&info](int checker, int delta, int screen, int leg)
+	{
+		if (info.count++ == 0)
+		{
+			info.checker = checker;
+			info.delta = delta;
+			info.screen = screen;
+			info.leg = leg;
+		}
+	};
+
+	int oppTag = opp_side_tag(side);
+	for (int i = 0; i < 4; ++i)
+	{
+		// 车、帅(将)照面以及炮
+		int delta = array_king_delta[i];
+		int pos = kingPos + delta;
+		while (in_board(pos) && !squares_[pos])
+		{
+			pos += delta;
+		}
+		if (!in_board(pos))
+			continue;
+		int pc = squares_[pos];
+		if ((pc & oppTag) &&
+				(pieceType(pc) == PIECE_TYPE_ROOK || pieceType(pc) == PIECE_TYPE_KING))
+			addChecker(pos, delta, 0, 0);
+
+		int screen = pos;
+		pos += delta;
+		while (in_board(pos) && !squares_[pos])
+		{
+			pos += delta;
+		}
+		if (!in_board(pos))
+			continue;
+		pc = squares_[pos];
+		if ((pc & oppTag) && pieceType(pc) == PIECE_TYPE_CANNON)
+			addChecker(pos, delta, screen, 0);
+	}
+
+	for (int i = 0; i < 4; ++i)
+	{
+		int leg = kingPos + array_advisor_delta[i];
+		if (squares_[leg])
+			continue;
+		for (int j = 0; j < 2; ++j)
+		{
+			int pos = kingPos + array_knight_check_delta[i][j];
+			int pc = squares_[pos];
+			if ((pc & oppTag) && pieceType(pc) == PIECE_TYPE_KNIGHT)
+				addChecker(pos, 0, 0, leg);
+		}
+	}
+
+	int forward = pawn_forward_delta(1 - side);
+	int pc = squares_[kingPos - forward];
+	if ((pc & oppTag) && pieceType(pc) == PIECE_TYPE_PAWN)
+		addChecker(kingPos - forward, 0, 0, 0);
+	for (int delta = -1; delta <= 1; delta += 2)
+	{
+		pc = squares_[kingPos + delta];
+		if ((pc & oppTag) && pieceType(pc) == PIECE_TYPE_PAWN && crossedRiver(pc))
+			addChecker(kingPos + delta, 0, 0, 0);
+	}
+}
+
+uint32_t Position::pinnedMask(int side) const
+{
+	int kingPos = this->kingPos(side);
+	if (!kingPos)
+		return 0;
+
+	uint32_t mask = 0;
+	int selfTag = side_tag(side);
+	int oppTag = opp_side_tag(side);
+	for (int i = 0; i < 4; ++i)
+	{
+		// 沿线找出最近的三个棋子
+		int delta = array_king_delta[i];
+		int found[3] = {0, 0, 0};
+		int pos = kingPos + delta;
+		for (int n = 0; n < 3 && in_board(pos); pos += delta)
+		{
+			if (squares_[pos])
+				found[n++] = squares_[pos];
+		}
+
+		// 己方棋子挡住对方的车或者帅(将)
+		if ((found[0] & selfTag) && (found[1] & oppTag))
+		{
+			int type = pieceType(found[1]);
+			if (type == PIECE_TYPE_ROOK || type == PIECE_TYPE_KING)
+				mask |= 1u << (found[0] - 16);
+		}
+		// 两个棋子都是对方炮的炮架，拿走任何一个都会被将军
+		if ((found[2] & oppTag) && pieceType(found[2]) == PIECE_TYPE_CANNON)
+		{
+			if (found[0] & selfTag)
+				mask |= 1u << (found[0] - 16);
+			if (found[1] & selfTag)
+				mask |= 1u << (found[1] - 16);
+		}
+
+		// 己方棋子蹩住了对方马的马腿
+		int leg = kingPos + array_advisor_delta[i];
+		int legPiece = squares_[leg];
+		if (legPiece & selfTag)
+		{
+			for (int j = 0; j < 2; ++j)
+			{
+				int pc = squares_[kingPos + array_knight_check_delta[i][j]];
+				if ((pc & oppTag) && pieceType(pc) == PIECE_TYPE_KNIGHT)
+					mask |= 1u << (legPiece - 16);
+			}
+		}
+	}
+	return mask;
+}
+
+} // namespace cppupdate
+} // namespace cchess
+} // namespace wsun
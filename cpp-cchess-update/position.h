@@ -0,0 +1,437 @@
+#ifndef __WSUN_CCHESS_CPP_UPDATE_POSITION_H__
+#define __WSUN_CCHESS_CPP_UPDATE_POSITION_H__
+
+#include <inttypes.h>
+#include <string.h>
+#include <type_traits>
+#include "utils.h"
+#include "zobrist_helper.h"
+#ifdef CCHESS_BITBOARD_BACKEND
+#include "bitboard.h"
+#endif
+
+namespace wsun
+{
+namespace cchess
+{
+namespace cppupdate
+{
+
+// 棋子编号：0表示没有棋子，16~31为红方棋子，32~47为黑方棋子，
+// 编号减去16就是该棋子在Position中的槽位
+inline static constexpr int side_tag(int side)
+{
+	return 16 + (side << 4);
+}
+
+inline static constexpr int opp_side_tag(int side)
+{
+	return 32 - (side << 4);
+}
+
+inline static int side_of_piece(int pc)
+{
+	return pc >> 5;
+}
+
+// side方棋子的槽位掩码，红方为槽位0~15，黑方为槽位16~31
+inline static constexpr uint32_t side_slots_mask(int side)
+{
+	return side == SIDE_TYPE_RED ? 0x0000ffffu : 0xffff0000u;
+}
+
+// 兵(卒)向前一步的偏移：红方在下方向上走，黑方在上方向下走
+inline static constexpr int pawn_forward_delta(int side)
+{
+	return side == SIDE_TYPE_RED ? -16 : 16;
+}
+
+// pos处side方的兵(卒)是否已过河：红方过河后在上半边，黑方过河后在下半边
+inline static constexpr bool pawn_crossed_river(int side, int pos)
+{
+	return ((pos & 0x80) != 0) == (side == SIDE_TYPE_BLACK);
+}
+
+// 将军信息，用于生成解将着法
+struct CheckInfo
+{
+	int count;			// 将军的棋子数
+	int checker;		// 将军棋子的位置(以下只在count为1时有效)
+	int delta;			// 车、炮、帅(将)沿线将军时从帅(将)指向将军棋子的方向
+	int screen;			// 炮将军时的炮架位置
+	int leg;				// 马将军时的马腿位置
+
+	// 非帅(将)的着法from->to是否可能解将：吃掉将军的棋子、垫子、蹩马腿或者移走炮架，
+	// 双将时无法快速判断，总是返回true
+	bool mayEvade(int kingPos, int from, int to) const
+	{
+		if (count != 1 || to == checker)
+			return true;
+		if (leg)
+			return to == leg;
+		if (!delta)
+			return false;
+		if (get_offset(kingPos, to) == delta && (checker - to) * delta > 0 && to != screen)
+			return true;
+		return from == screen;
+	}
+};
+
+static const int PIECE_SLOTS = 32;
+static const int SIDE_PIECE_SLOTS = 16;
+
+// 局面：棋盘、32个棋子槽位、子力价值、zobrist值以及下棋方，
+// 不含任何指针，可以直接memcpy拷贝
+class Position
+{
+public:
+	void clear()
+	{
+		memset(squares_, 0, sizeof(squares_));
+		memset(slotPos_, 0, sizeof(slotPos_));
+		memset(slotType_, 0, sizeof(slotType_));
+		memset(rankBits_, 0, sizeof(rankBits_));
+		memset(fileBits_, 0, sizeof(fileBits_));
+		memset(pieceCount_, 0, sizeof(pieceCount_));
+#ifdef CCHESS_ATTACK_MAPS
+		memset(attackers_, 0, sizeof(attackers_));
+#endif
+		slotsNum_[0] = slotsNum_[1] = 0;
+		kings_[0] = kings_[1] = 0;
+		value_[0] = value_[1] = 0;
+		side_ = SIDE_TYPE_RED;
+		zobristHelper_.reset();
+#ifdef CCHESS_BITBOARD_BACKEND
+		bitboards_.reset();
+#endif
+	}
+
+	SideType side() const { return (SideType)side_; }
+	int value(int side) const { return value_[side]; }
+	const Zobrist& getZobrist() const { return zobristHelper_.getZobrist(); }
+	const Zobrist& getMirrorZobrist() const { return zobristHelper_.getMirrorZobrist(); }
+
+	// pos处的棋子编号，没有棋子为0
+	int pieceAt(int pos) const { return squares_[pos]; }
+	int piecePos(int pc) const { return slotPos_[pc - 16]; }
+	PieceType pieceType(int pc) const { return (PieceType)slotType_[pc - 16]; }
+	PieceType typeAt(int pos) const
+	{
+		return squares_[pos] ? pieceType(squares_[pos]) : PIECE_TYPE_NONE;
+	}
+	int kingPos(int side) const { return kings_[side] ? piecePos(kings_[side]) : 0; }
+	// pos所在行(列)的占位，按横(纵)坐标置位
+	int rankBits(int pos) const { return rankBits_[pos >> 4]; }
+	int fileBits(int pos) const { return fileBits_[pos & 15]; }
+	// 某方已分配的槽位数，槽位从side_tag(side)开始，位置为0表示已被吃掉
+	int slotsNum(int side) const { return slotsNum_[side]; }
+	// side方在棋盘上的type类棋子数以及它们的棋子编号，不含已被吃掉的棋子
+	int pieceCount(int side, int type) const { return pieceCount_[side][type]; }
+	const uint8_t* pieceList(int side, int type) const { return pieceList_[side][type]; }
+
+#ifdef CCHESS_BITBOARD_BACKEND
+	const BitboardSet& bitboards() const { return bitboards_; }
+#endif
+
+	// 攻击表：pos处如果有对方的棋子，哪些棋子能吃到它，按(棋子编号-16)置位，帅(将)照面也算攻击。
+	// 定义CCHESS_ATTACK_MAPS时随走棋增量更新、直接查表，否则按当前局面现算
+#ifdef CCHESS_ATTACK_MAPS
+	uint32_t attackers(int pos) const { return attackers_[pos]; }
+#else
+	uint32_t attackers(int pos) const { return computeAttackers(pos); }
+#endif
+	uint32_t attackers(int pos, int bySide) const { return attackers(pos) & side_slots_mask(bySide); }
+	bool attacked(int pos, int bySide) const { return attackers(pos, bySide) != 0; }
+	int attackCount(int pos, int bySide) const { return __builtin_popcount(attackers(pos, bySide)); }
+	// 不查攻击表，从pos出发反向找出所有攻击者
+	uint32_t computeAttackers(int pos) const;
+
+	// 静态交换评估：from处的棋子吃掉to处的棋子之后，双方轮流用最便宜的棋子在to上兑换，
+	// 返回吃子一方的子力得失。每吃一步都重新找攻击者，炮架、马腿、象眼、车后面的车炮
+	// 和帅(将)照面都会随之变化。只临时改动squares_，返回前复原
+	int see(int from, int to);
+	// 吃子走法按静态交换评估是否亏子，被吃的棋子不比吃子的便宜时不用计算
+	bool losingCapture(int from, int to);
+
+	// 棋子的子力价值，每方的表已经按各自视角翻转好
+	static int pieceValue(int side, int type, int pos)
+	{
+		return array_piece_value[side][type][pos];
+	}
+
+	// 走到dest的吃子走法的MVV/LVA分值，不吃子为0
+	int mvvLva(int type, int dest) const
+	{
+		int pc = squares_[dest];
+		return pc ? array_mvv_lva[slotType_[pc - 16]] * 10 - array_mvv_lva[type] : 0;
+	}
+
+	// 兵(卒)向前一步的位置
+	int forwardStep(int pc) const
+	{
+		return piecePos(pc) + pawn_forward_delta(side_of_piece(pc));
+	}
+
+	// 兵(卒)是否已过河
+	bool crossedRiver(int pc) const
+	{
+		return pawn_crossed_river(side_of_piece(pc), piecePos(pc));
+	}
+
+	void changeSide()
+	{
+		side_ ^= 1;
+		zobristHelper_.updateByChangeSide();
+	}
+
+	// 摆放一个新棋子(初始化局面时使用)，返回棋子编号，槽位已满返回0
+	int addNewPiece(SideType side, PieceType type, int pos)
+	{
+		if (slotsNum_[side] == SIDE_PIECE_SLOTS)
+			return 0;
+		int pc = side_tag(side) + slotsNum_[side]++;
+		slotType_[pc - 16] = (uint8_t)type;
+		if (type == PIECE_TYPE_KING)
+			kings_[side] = (uint8_t)pc;
+#ifdef CCHESS_ATTACK_MAPS
+		uint32_t dependents = attackDependents(pos);
+		toggleAttacks(dependents);
+#endif
+		placePiece(pc, pos);
+		listPiece(pc);
+#ifdef CCHESS_ATTACK_MAPS
+		toggleAttacks(dependents | (1u << (pc - 16)));
+#endif
+		value_[side] += pieceValue(side, type, pos);
+		zobristHelper_.updateByChangePiece(side, type, pos);
+		return pc;
+	}
+
+	// 把from处的棋子走到to，更新子力价值和zobrist，返回被吃掉的棋子编号
+	int movePiece(int from, int to)
+	{
+		int captured = squares_[to];
+		int pc = squares_[from];
+#ifdef CCHESS_ATTACK_MAPS
+		// 先按走棋前的占位去掉受影响棋子的攻击，走完之后再加回来
+		uint32_t dependents = attackDependents(from) | attackDependents(to) | (1u << (pc - 16));
+		if (captured)
+			dependents |= 1u << (captured - 16);
+		toggleAttacks(dependents);
+#endif
+
+		if (captured)
+		{
+			int capSide = side_of_piece(captured);
+			int capType = slotType_[captured - 16];
+			removePiece(captured, to);
+			unlistPiece(captured);
+			value_[capSide] -= pieceValue(capSide, capType, to);
+			zobristHelper_.updateByChangePiece(capSide, capType, to);
+		}
+
+		int side = side_of_piece(pc);
+		int type = slotType_[pc - 16];
+		removePiece(pc, from);
+		placePiece(pc, to);
+		value_[side] += pieceValue(side, type, to) - pieceValue(side, type, from);
+		zobristHelper_.updateByChangePiece(side, type, from);
+		zobristHelper_.updateByChangePiece(side, type, to);
+#ifdef CCHESS_ATTACK_MAPS
+		toggleAttacks(dependents);
+#endif
+		return captured;
+	}
+
+	// side方的帅(将)是否被攻击，从帅(将)出发检查四条线、四个马腿和兵(卒)
+	bool checked(int side) const;
+
+	// side方刚走了from->to(局面已更新)，己方帅(将)是否因此被攻击，
+	// 只检查经过from、to的线路和马腿，要求走之前没有被将军且走的不是帅(将)
+	bool exposedByMove(int side, int from, int to) const;
+
+	// 对方刚走了from->to(局面已更新)，side方的帅(将)是否被将军，
+	// 只检查走动的棋子以及经过from、to的线路和马腿
+	bool checkedByMove(int side, int from, int to) const;
+
+	// 假设走了from->to(只临时改动棋盘，随后复原)，走棋方的帅(将)是否被攻击
+	bool checkedAfterMove(int from, int to);
+
+	// 假设走了from->to(只临时改动棋盘，随后复原)，是否将军对方的帅(将)，
+	// 只检查走动的棋子以及经过from、to的线路和马腿
+	bool givesCheck(int from, int to);
+
+	// 统计side方帅(将)受到的将军
+	void checkInfo(int side, CheckInfo& info) const;
+
+	// side方被牵制的棋子：离开原位置就会让己方帅(将)被攻击，按(棋子编号-16)置位
+	uint32_t pinnedMask(int side) const;
+
+	// 撤销from->to的走法：只把棋子挪回去，子力价值和zobrist直接恢复为走棋前保存的值，
+	// side为走棋前的下棋方，走棋之后已经换过边的话zobrist保持当前的下棋方
+	void undoMove(int from, int to, int captured, int side,
+			const Zobrist& zobrist, const Zobrist& mirrorZobrist, const int* value)
+	{
+		int pc = squares_[to];
+#ifdef CCHESS_ATTACK_MAPS
+		uint32_t dependents = attackDependents(from) | attackDependents(to) | (1u << (pc - 16));
+		if (captured)
+			dependents |= 1u << (captured - 16);
+		toggleAttacks(dependents);
+#endif
+		removePiece(pc, to);
+		placePiece(pc, from);
+		if (captured)
+		{
+			placePiece(captured, to);
+			relistPiece(captured);
+		}
+#ifdef CCHESS_ATTACK_MAPS
+		toggleAttacks(dependents);
+#endif
+		value_[0] = value[0];
+		value_[1] = value[1];
+		zobristHelper_.setZobrist(zobrist, mirrorZobrist);
+		if (side != side_)
+			zobristHelper_.updateByChangeSide();
+	}
+
+private:
+	// 临时走一步from->to，只改动squares_和slotPos_(不更新行列占位等)，析构时复原。
+	// 用于不真正走棋就判断走完之后的将军
+	class ScopedMove
+	{
+	public:
+		ScopedMove(Position& position, int from, int to)
+			: position_(position), from_(from), to_(to),
+				piece_(position.squares_[from]), captured_(position.squares_[to])
+		{
+			position_.squares_[from_] = 0;
+			position_.squares_[to_] = (uint8_t)piece_;
+			position_.slotPos_[piece_ - 16] = (uint8_t)to_;
+			if (captured_)
+				position_.slotPos_[captured_ - 16] = 0;
+		}
+
+		~ScopedMove()
+		{
+			position_.squares_[from_] = (uint8_t)piece_;
+			position_.squares_[to_] = (uint8_t)captured_;
+			position_.slotPos_[piece_ - 16] = (uint8_t)from_;
+			if (captured_)
+				position_.slotPos_[captured_ - 16] = (uint8_t)to_;
+		}
+
+		ScopedMove(const ScopedMove&) = delete;
+		ScopedMove& operator=(const ScopedMove&) = delete;
+
+		int piece() const { return piece_; }
+
+	private:
+		Position& position_;
+		int from_;
+		int to_;
+		int piece_;
+		int captured_;
+	};
+
+	// 只改动棋盘上的棋子，不更新子力价值和zobrist
+	void placePiece(int pc, int pos)
+	{
+		squares_[pos] = (uint8_t)pc;
+		slotPos_[pc - 16] = (uint8_t)pos;
+		rankBits_[pos >> 4] ^= (uint16_t)(1 << (pos & 15));
+		fileBits_[pos & 15] ^= (uint16_t)(1 << (pos >> 4));
+#ifdef CCHESS_BITBOARD_BACKEND
+		bitboards_.toggle(side_of_piece(pc), slotType_[pc - 16], pos);
+#endif
+	}
+
+	void removePiece(int pc, int pos)
+	{
+		squares_[pos] = 0;
+		slotPos_[pc - 16] = 0;
+		rankBits_[pos >> 4] ^= (uint16_t)(1 << (pos & 15));
+		fileBits_[pos & 15] ^= (uint16_t)(1 << (pos >> 4));
+#ifdef CCHESS_BITBOARD_BACKEND
+		bitboards_.toggle(side_of_piece(pc), slotType_[pc - 16], pos);
+#endif
+	}
+
+	// 把棋子加到所属列表的末尾
+	void listPiece(int pc)
+	{
+		int side = side_of_piece(pc);
+		int type = slotType_[pc - 16];
+		int idx = pieceCount_[side][type]++;
+		pieceList_[side][type][idx] = (uint8_t)pc;
+		listIndex_[pc - 16] = (uint8_t)idx;
+	}
+
+	// 被吃掉的棋子从列表中移除：把末尾的棋子换到它的位置
+	void unlistPiece(int pc)
+	{
+		int side = side_of_piece(pc);
+		int type = slotType_[pc - 16];
+		uint8_t* list = pieceList_[side][type];
+		int idx = listIndex_[pc - 16];
+		int last = list[--pieceCount_[side][type]];
+		list[idx] = (uint8_t)last;
+		listIndex_[last - 16] = (uint8_t)idx;
+	}
+
+	// unlistPiece的逆操作，要求按吃子的相反顺序恢复：棋子放回原下标，
+	// 占着该下标的棋子回到末尾，列表顺序与吃子前完全相同
+	void relistPiece(int pc)
+	{
+		int side = side_of_piece(pc);
+		int type = slotType_[pc - 16];
+		uint8_t* list = pieceList_[side][type];
+		int idx = listIndex_[pc - 16];
+		int last = pieceCount_[side][type]++;
+		list[last] = list[idx];
+		listIndex_[list[idx] - 16] = (uint8_t)last;
+		list[idx] = (uint8_t)pc;
+	}
+
+#ifdef CCHESS_ATTACK_MAPS
+	// pos处的占位变化会影响攻击范围的棋子：pos所在行、列上的车、炮、帅(将)，
+	// 以pos为马腿的马，以pos为象眼的相(象)，按(棋子编号-16)置位
+	uint32_t attackDependents(int pos) const;
+	// 按当前占位把slots中在棋盘上的棋子的攻击在攻击表中翻转(加上或者去掉)
+	void toggleAttacks(uint32_t slots);
+#endif
+
+	// 从帅(将)出发沿delta方向是否受到车、帅(将)或者炮的攻击
+	bool lineChecked(int side, int kingPos, int delta) const;
+	// 从帅(将)出发，经过第i个斜向马腿是否受到马的攻击
+	bool knightChecked(int side, int kingPos, int i) const;
+
+	uint8_t squares_[256];						// 棋盘上每个位置的棋子编号
+	uint8_t slotPos_[PIECE_SLOTS];		// 每个槽位中棋子的位置，0表示不在棋盘上
+	uint8_t slotType_[PIECE_SLOTS];		// 每个槽位中棋子的类型
+	uint16_t rankBits_[16];						// 每一行的占位
+	uint16_t fileBits_[16];						// 每一列的占位
+	uint8_t pieceList_[2][PIECE_TYPE_NUMBER][SIDE_PIECE_SLOTS];	// 双方按类型分组的在场棋子
+	uint8_t pieceCount_[2][PIECE_TYPE_NUMBER];
+	uint8_t listIndex_[PIECE_SLOTS];	// 每个槽位中的棋子在所属列表中的下标
+	uint8_t slotsNum_[2];
+	uint8_t kings_[2];								// 双方帅(将)的棋子编号
+	uint8_t side_;										// 当前下棋方
+	int value_[2];										// 双方的子力价值总分数
+#ifdef CCHESS_ATTACK_MAPS
+	uint32_t attackers_[256];					// 攻击表，见attackers()
+#endif
+	ZobristHelper zobristHelper_;
+#ifdef CCHESS_BITBOARD_BACKEND
+	BitboardSet bitboards_;
+#endif
+};
+
+static_assert(std::is_trivially_copyable<Position>::value, "Position must be trivially copyable");
+
+} // namespace cppupdate
+} // namespace cchess
+} // namespace wsun
+
+#endif
@@ -3,6 +3,8 @@
 #include <sys/time.h>
 #include <stdio.h>
 #include <algorithm>
+#include <climits>
+#include <thread>
 
 namespace wsun
 {
@@ -21,32 +23,6 @@ static const int HASH_PV = 3;
 #define STATE_GENE 3
 #define STATE_REST 4
 
-struct CompareByHistory
-{
-	CompareByHistory(SearchEngine* engine) : engine_(engine)
-	{
-	}
-	bool operator()(int left, int right)
-	{
-		return engine_->getHistoryHeuristicTable()[right] < engine_->getHistoryHeuristicTable()[left];
-	}
-
-	SearchEngine* engine_;
-};
-
-struct CompareByMvvLua
-{
-	CompareByMvvLua(Board* board) : board_(board)
-	{
-	}
-	bool operator()(int left, int right)
-	{
-		return board_->mvvLva(right) < board_->mvvLva(left);
-	}
-
-	Board* board_;
-};
-
 // return milliseconds
 static uint64_t now()
 {
@@ -55,49 +31,71 @@ static uint64_t now()
 	return tm.tv_sec * 1000000 + tm.tv_usec;
 }
 
+// 按静态交换评估调整吃子走法的分值：赚子的排在所有按历史表打分的走法之前，
+// 亏子的排在最后，不赚不亏的仍按历史表
+static const int SEE_WINNING_SCORE = 1 << 28;
+static const int SEE_LOSING_SCORE = -(1 << 28);
+// 静态搜索中不吃子的将军着法的分值，排在所有吃子着法之后
+static const int QUIET_CHECK_SCORE = INT_MIN / 2;
+
+static void score_captures_by_see(Board* board, MoveList& list)
+{
+	for (int i = 0; i < list.size; ++i)
+	{
+		Move mv = list.moves[i].move;
+		if (!board->position().pieceAt(mv.end()))
+			continue;
+		int value = board->see(mv);
+		if (value > 0)
+			list.moves[i].score = SEE_WINNING_SCORE + value;
+		else if (value < 0)
+			list.moves[i].score = SEE_LOSING_SCORE + value;
+	}
+}
+
 // 走法排序生成器
 struct moves_generate_sorter
 {
+	moves_generate_sorter(SearchEngine* e)
+		: engine(e), list(e->getHistoryHeuristicTable().data()), killer_move1(), killer_move2() {}
+
 	SearchEngine* engine;
-	int mvs[MAX_GENERATE_MOVES];
-	int mvs_size;
+	MoveList list;
 	int mvs_idx;
-	int mv_tt;
+	Move mv_tt;
 	int state;
-	int killer_move1;
-	int killer_move2;
+	Move killer_move1;
+	Move killer_move2;
 };
 
-void moves_generate_sorter_init(struct moves_generate_sorter* sorter, SearchEngine* engine, int mv_tt)
+template <SideType us>
+void moves_generate_sorter_init(struct moves_generate_sorter* sorter, Move mv_tt)
 {
-	memset(sorter, 0, sizeof(struct moves_generate_sorter));
-	sorter->engine = engine;
+	SearchEngine* engine = sorter->engine;
+	sorter->mvs_idx = 0;
 	sorter->mv_tt = mv_tt;
 	// 如果被将军的话就不能直接用置换表启发和杀手启发走法
-	if (engine->board()->willKillSelfKing())
+	if (engine->board()->inCheck())
 	{
 		sorter->state = STATE_REST;
-		int n = engine->board()->generateAllMoves<GENERAL>(sorter->mvs);
-		sorter->mvs_size = n;
-		std::sort(sorter->mvs, sorter->mvs + n, CompareByHistory(engine));
-		int tmp_killer_move1 = engine->getKillerMove(0);
-		int tmp_killer_move2 = engine->getKillerMove(1);
-		if (mv_tt != 0 &&
-				std::find(sorter->mvs, sorter->mvs + n, mv_tt) != sorter->mvs + n)
+		engine->board()->generateAllMoves<GENERAL, us>(sorter->list);
+		score_captures_by_see(engine->board(), sorter->list);
+		sorter->list.sort();
+		Move tmp_killer_move1 = engine->getKillerMove(0);
+		Move tmp_killer_move2 = engine->getKillerMove(1);
+		if (mv_tt && sorter->list.contains(mv_tt))
 		{
       sorter->mvs_idx = 1;
 			sorter->mv_tt = mv_tt;
 			sorter->state = STATE_TT;
 		}
-		if (tmp_killer_move1 != 0 && 
-				std::find(sorter->mvs, sorter->mvs + n, tmp_killer_move1) != sorter->mvs + n)
+		if (tmp_killer_move1 && sorter->list.contains(tmp_killer_move1))
 		{
       sorter->mvs_idx = 1;
 			sorter->killer_move1 = tmp_killer_move1;
 			if (sorter->state == STATE_REST) sorter->state = STATE_KILLER1;
 		}
-		if (tmp_killer_move2 != 0 && 
-				std::find(sorter->mvs, sorter->mvs + n, tmp_killer_move2) != sorter->mvs + n)
+		if (tmp_killer_move2 && sorter->list.contains(tmp_killer_move2))
 		{
       sorter->mvs_idx = 1;
 			sorter->killer_move2 = tmp_killer_move2;
@@ -113,138 +111,143 @@ void moves_generate_sorter_init(struct moves_generate_sorter* sorter, SearchEngi
 	//sorter->state = mv_tt == 0 ? STATE_GENE : STATE_TT;
 }
 
-int moves_generate_sorter_next_move(struct moves_generate_sorter* sorter)
+template <SideType us>
+Move moves_generate_sorter_next_move(struct moves_generate_sorter* sorter)
 {
-	int n = 0;
 	switch(sorter->state)
 	{
 		case STATE_TT:
 			//sorter->state = STATE_GENE;
 			sorter->state = STATE_KILLER1;
-			if (sorter->mv_tt != 0)
+			// 置换表走法可能来自校验值冲突的其他局面，必须先验证
+			if (sorter->mv_tt && sorter->engine->board()->isPseudoLegal(sorter->mv_tt))
 				return sorter->mv_tt;
+			sorter->mv_tt = Move();
+			[[fallthrough]];
 		case STATE_KILLER1:
 			sorter->state = STATE_KILLER2;
-			if (sorter->killer_move1 != 0 && 
+			if (sorter->killer_move1 && 
 					sorter->killer_move1 != sorter->mv_tt &&
-					sorter->engine->board()->legalMove(sorter->killer_move1))
+					sorter->engine->board()->isPseudoLegal(sorter->killer_move1))
 			{
 				// printf("从杀手表1中检索到杀棋\n");
 				return sorter->killer_move1;
 			}
+			[[fallthrough]];
 		case STATE_KILLER2:
 			sorter->state = STATE_GENE;
-			if (sorter->killer_move2 != 0 && 
+			if (sorter->killer_move2 && 
 					sorter->killer_move2 != sorter->mv_tt &&
 					sorter->killer_move2 != sorter->killer_move1 &&
-					sorter->engine->board()->legalMove(sorter->killer_move2))
+					sorter->engine->board()->isPseudoLegal(sorter->killer_move2))
 			{
 				// printf("从杀手表2中检索到杀棋\n");
 				return sorter->killer_move2;
 			}
+			[[fallthrough]];
 		case STATE_GENE:
 			sorter->state = STATE_REST;
-      if (sorter->mvs_size == 0) {
-        n = sorter->engine->board()->generateAllMoves<GENERAL>(sorter->mvs);
-        std::sort(sorter->mvs, sorter->mvs + n, CompareByHistory(sorter->engine));
-        sorter->mvs_size = n;
+      if (sorter->list.size == 0) {
+        sorter->engine->board()->generateAllMoves<GENERAL, us>(sorter->list);
+        score_captures_by_see(sorter->engine->board(), sorter->list);
+        sorter->list.sort();
       }
+			[[fallthrough]];
 		case STATE_REST:
-			while (sorter->mvs_idx < sorter->mvs_size)
+			while (sorter->mvs_idx < sorter->list.size)
 			{
-				int mv = sorter->mvs[sorter->mvs_idx++];
+				Move mv = sorter->list.moves[sorter->mvs_idx++].move;
 				if (mv != sorter->mv_tt &&
 						mv != sorter->killer_move1 && 
 						mv != sorter->killer_move2)
 					return mv;
 			}
+			[[fallthrough]];
 		default:
-			return 0;
+			return Move();
 	}
 }
 
-int SearchEngine::transpositionTableGrab(int vlAlpha, int vlBeta, int depth, int* mv)
+int SearchEngine::transpositionTableGrab(int vlAlpha, int vlBeta, int depth, Move* mv)
 {
-	const Zobrist* zobrist = &board_->getZobrist();
-	tt_item* item = &transpositionTable_[((TRANSPOSITION_TABLE_SIZE - 1) & zobrist->key_)];
-	if (item->checksum_lower32 != zobrist->lock1_ || item->checksum_higher32 != zobrist->lock2_)
+	TTData item;
+	if (!transpositionTable_->probe(board_->getZobrist(), &item))
 	{
-		*mv = 0;
+		*mv = Move();
 		return -MATE_VALUE;
 	}
 
-	*mv = item->mv;
+	*mv = item.mv;
+	// 条目可能被其他线程同时读取，杀棋步数只在局部调整
+	int value = item.value;
 	int mate = 0;
-	if (item->value > WIN_VALUE)
+	if (value > WIN_VALUE)
 	{
-		if (item->value <= BAN_VALUE)
+		if (value <= BAN_VALUE)
 			return -MATE_VALUE;
-		item->value -= distance_;
+		value -= distance_;
 		mate = 1;
 	}
-	else if (item->value < -WIN_VALUE)
+	else if (value < -WIN_VALUE)
 	{
-		if (item->value >= -BAN_VALUE)
+		if (value >= -BAN_VALUE)
 		{
 			return -MATE_VALUE;
 		}
-		item->value += distance_;
+		value += distance_;
 		mate = 1;
 	}
-	else if (item->value == drawValue())
+	else if (value == drawValue())
 	{
 		return -MATE_VALUE;
 	}
 
-	if (item->depth < depth && !mate)
+	if (item.depth < depth && !mate)
 	{
 		return -MATE_VALUE;
 	}
-	if (item->flag == HASH_BETA)
+	if (item.flag == HASH_BETA)
 	{
-		return (item->value >= vlBeta ? item->value : -MATE_VALUE);
+		return (value >= vlBeta ? value : -MATE_VALUE);
 	}
-	if (item->flag == HASH_ALPHA)
+	if (item.flag == HASH_ALPHA)
 	{
-		return (item->value <= vlAlpha ? item->value : -MATE_VALUE);
+		return (value <= vlAlpha ? value : -MATE_VALUE);
 	}
-	return item->value;
+	return value;
 }
 
-void SearchEngine::transpositionTableInsert(int flag, int value, int depth, int mv)
+void SearchEngine::transpositionTableInsert(int flag, int value, int depth, Move mv)
 {
-	const Zobrist* zobrist = &board_->getZobrist();
-	struct tt_item* item = &transpositionTable_[((TRANSPOSITION_TABLE_SIZE - 1) & zobrist->key_)];
-	if (item->depth > depth)
-		return ;
-
-	item->flag = flag;
-	item->depth = depth;
+	TTData item;
+	item.flag = flag;
+	item.depth = depth;
 	if (value > WIN_VALUE)
 	{
-		if (mv == 0 && value <= BAN_VALUE) return;
-		item->value = value + distance_;
+		if (!mv && value <= BAN_VALUE) return;
+		item.value = value + distance_;
 	}
 	else if (value < -WIN_VALUE)
 	{
-		if (mv == 0 && value >= -BAN_VALUE) return;
-		item->value = value - distance_;
+		if (!mv && value >= -BAN_VALUE) return;
+		item.value = value - distance_;
 	}
-	else if (value == drawValue() && mv == 0)
+	else if (value == drawValue() && !mv)
 	{
 		return ;
 	}
 	else
 	{
-		item->value = value;
+		item.value = value;
 	}
-	item->mv = mv;
-	item->checksum_lower32 = zobrist->lock1_;
-	item->checksum_higher32 = zobrist->lock2_;
+	item.mv = mv;
+	transpositionTable_->store(board_->getZobrist(), item);
 }
 
-int SearchEngine::searchQuiescence(int value_alpha, int value_beta)
+template <MakeMovePolicy policy, SideType us>
+int SearchEngine::searchQuiescence(int value_alpha, int value_beta, bool checks)
 {
+	constexpr SideType them = (SideType)(1 - us);
 	//printf("search quiescence\n");
 	ndepth_ = ndepth_ < distance_ ? distance_ : ndepth_;
 	++allNodes_;
@@ -261,56 +264,102 @@ int SearchEngine::searchQuiescence(int value_alpha, int value_beta)
 		return repetitionValue(value_rep);
 	}
 
+	// 3. 置换表裁剪，静态搜索按深度0读写，任何深度的条目都可以使用
+	Move mv_tt = Move();
+	value = transpositionTableGrab(value_alpha, value_beta, 0, &mv_tt);
+	if (value > -MATE_VALUE)
+		return value;
+
 	if (distance_ == LIMIT_DEPTH)
 	{
 		printf("Quiesc limit depth\n");
-		return board_->evaluate();
+		return board_->evaluate<us>();
 	}
 
 	// 4. 初始化
+	int tt_flag = HASH_ALPHA;
 	int value_best = -MATE_VALUE;
+	Move mv_best = Move();
+	bool in_check = board_->inCheck();
 
-	int mvs[MAX_GENERATE_MOVES];
 	int n = 0;
-	if (board_->willKillSelfKing())
+	MoveList list(in_check ? historyHeuristicTable_.data() : nullptr);
+	if (in_check)
 	{
-		n = board_->generateAllMoves<GENERAL>(mvs);
-		std::sort(mvs, mvs + n, CompareByHistory(this));
+		n = board_->generateAllMoves<GENERAL, us>(list);
 	}
 	else
 	{
-		value = board_->evaluate();
+		value = board_->evaluate<us>();
 		if (value > value_best)
 		{
 			if (value >= value_beta)
 			{
+				transpositionTableInsert(HASH_BETA, value, 0, Move());
 				return value;
 			}
 			value_best = value;
 			value_alpha = value > value_alpha ? value : value_alpha;
 		}
 
-		// 对于未被将军的局面，生成并排序所有吃子着法（MVV/LVA启发）
-		n = board_->generateAllMoves<CAPTURE>(mvs);
-		std::sort(mvs, mvs + n, CompareByMvvLua(this->board()));
+		// 对于未被将军的局面，生成所有吃子着法（MVV/LVA启发），
+		// 静态交换评估亏子的吃子，以及吃掉之后加上余量也达不到alpha的吃子(delta裁剪)直接裁剪掉
+		n = board_->generateAllMoves<CAPTURE, us>(list);
+		int kept = 0;
+		for (int i = 0; i < n; ++i)
+		{
+			Move mv = list.moves[i].move;
+			if (value_best + board_->captureValue(mv) + QUIESC_DELTA_MARGIN <= value_alpha)
+				continue;
+			if (!board_->losingCapture(mv))
+				list.moves[kept++] = list.moves[i];
+		}
+		n = list.size = kept;
+
+		// 静态搜索的第一层再加上不吃子的将军着法，排在吃子之后。
+		// 按走动的棋子以及经过起点、终点的线路和马腿判断是否将军，不用逐个走棋
+		if (checks)
+		{
+			MoveList quiet;
+			int count = board_->generateAllMoves<GENERAL, us>(quiet);
+			for (int i = 0; i < count; ++i)
+			{
+				Move mv = quiet.moves[i].move;
+				if (!board_->isCapatured(mv) && board_->givesCheck(mv))
+					list.moves[list.size++] = { mv, QUIET_CHECK_SCORE };
+			}
+			n = list.size;
+		}
 	}
+	list.prefer(mv_tt);
 
+	// 大多数节点在前几个走法就截断了，每次只挑出剩下走法中分值最高的一个，不做整体排序
 	for (int i = 0; i < n; ++i)
 	{
-		int mv = mvs[i];
-		if (!makeMove(mv)) 
+		list.pickBest(i);
+		Move mv = list.moves[i].move;
+		if (!makeMove<policy>(mv)) 
 			continue;
 
-		value = -searchQuiescence(-value_beta, -value_alpha);
-		undoMove();
+		value = -searchQuiescence<policy, them>(-value_beta, -value_alpha, false);
+		undoMove<policy>();
+		if (stopped())
+			return 0;
 		if (value > value_best)
 		{
+			value_best = value;
 			if (value >= value_beta)
 			{
-				return value;
+				mv_best = mv;
+				tt_flag = HASH_BETA;
+				break;
+			}
+			if (value > value_alpha)
+			{
+				value_alpha = value;
+				mv_best = mv;
+				tt_flag = HASH_PV;
 			}
-			value_best = value;
-			value_alpha = value > value_alpha ? value : value_alpha;
 		}
 	}
 
@@ -318,18 +367,18 @@ int SearchEngine::searchQuiescence(int value_alpha, int value_beta)
 	{
 		return mateValue();
 	}
-	else
-	{
-		return value_best;
-	}
 
+	transpositionTableInsert(tt_flag, value_best, 0, mv_best);
+	return value_best;
 }
 
+template <MakeMovePolicy policy, SideType us>
 int SearchEngine::searchFull(int value_alpha, int value_beta, int depth, int nonull)
 {
+	constexpr SideType them = (SideType)(1 - us);
 	// 1. 到达水平线，由于水平线效应，应进行静态搜索
 	if (depth <= 0) {
-		return searchQuiescence(value_alpha, value_beta);
+		return searchQuiescence<policy, us>(value_alpha, value_beta, quiescenceChecks_);
 	}
 
 	++allNodes_; // 更新搜索节点数
@@ -347,7 +396,7 @@ int SearchEngine::searchFull(int value_alpha, int value_beta, int depth, int non
 		return repetitionValue(value_rep);
 	}
 
-	int mv_tt = 0;
+	Move mv_tt = Move();
 	value = transpositionTableGrab(value_alpha, value_beta, depth, &mv_tt);
 	if (value > -MATE_VALUE)
 		return value;
@@ -356,17 +405,19 @@ int SearchEngine::searchFull(int value_alpha, int value_beta, int depth, int non
 	if (distance_ == LIMIT_DEPTH)
 	{
 		printf("searchfull limit depth\n");
-		return board_->evaluate();
+		return board_->evaluate<us>();
 	}
 
 	// 空步裁剪
-	if (!nonull && !board_->willKillSelfKing() && nullOkay())
+	if (!nonull && !board_->inCheck() && nullOkay<us>())
 	{
 		doNullMove();
-		value = -searchFull(-value_beta, 1 - value_beta, depth - NULL_DEPTH - 1, 1);
+		value = -searchFull<policy, them>(-value_beta, 1 - value_beta, depth - NULL_DEPTH - 1, 1);
 		undoNullMove();
+		if (stopped())
+			return 0;
 		if (value >= value_beta && 
-				(nullSafe() || searchFull(value_alpha, value_beta, depth - NULL_DEPTH, 1) >= value_beta))
+				(nullSafe<us>() || searchFull<policy, us>(value_alpha, value_beta, depth - NULL_DEPTH, 1) >= value_beta))
 		{
 			return value;
 		}
@@ -374,39 +425,41 @@ int SearchEngine::searchFull(int value_alpha, int value_beta, int depth, int non
 
 	int tt_flag = HASH_ALPHA;
 	int value_best = -MATE_VALUE;
-	int mv_best = 0;
-	int mv = 0;
+	Move mv_best = Move();
+	Move mv;
 	int new_depth = 0;
 
-	struct moves_generate_sorter sorter;
-	moves_generate_sorter_init(&sorter, this, mv_tt);
+	struct moves_generate_sorter sorter(this);
+	moves_generate_sorter_init<us>(&sorter, mv_tt);
 
-	while ((mv = moves_generate_sorter_next_move(&sorter)) > 0)
+	while ((mv = moves_generate_sorter_next_move<us>(&sorter)))
 	{
-		if (!makeMove(mv))
+		if (!makeMove<policy>(mv))
 			continue;
 
 		//将军延伸(即将军的走法应该让它多搜索一层)
-		new_depth = board_->willKillSelfKing() ? depth : depth - 1;
+		new_depth = board_->inCheck() ? depth : depth - 1;
 
 		// PVS算法
 		// 先对第一个走法做全窗口搜索
 		if (value_best == -MATE_VALUE)
 		{
-			value = -searchFull(-value_beta, -value_alpha, new_depth, 0);
+			value = -searchFull<policy, them>(-value_beta, -value_alpha, new_depth, 0);
 		}
 		else
 		{
 			// 根据对第一个走法做全窗口搜索得到的下边界的值，对剩余的走法做零窗口搜索
-			value = -searchFull(-value_alpha - 1, -value_alpha, new_depth, 0);
+			value = -searchFull<policy, them>(-value_alpha - 1, -value_alpha, new_depth, 0);
 
 			// 检验零窗口搜索, 搜索失败则再对其进行全窗口搜索
 			if (value > value_alpha && value < value_beta)
 			{
-				value = -searchFull(-value_beta, -value_alpha, new_depth, 0);
+				value = -searchFull<policy, them>(-value_beta, -value_alpha, new_depth, 0);
 			}
 		}
-		undoMove();
+		undoMove<policy>();
+		if (stopped())
+			return 0;
 
 		// 找到更好的走法，并保存走法以及走法所对应的分值
 		if (value > value_best)
@@ -439,7 +492,7 @@ int SearchEngine::searchFull(int value_alpha, int value_beta, int depth, int non
 	transpositionTableInsert(tt_flag, value_best, depth, mv_best);
 
 	//把最佳走法保存到历史表，返回最佳分值
-	if (mv_best > 0)
+	if (mv_best)
 	{
 		setBestMove(mv_best, depth);
 	}
@@ -447,87 +500,172 @@ int SearchEngine::searchFull(int value_alpha, int value_beta, int depth, int non
 	return value_best;
 }
 
-int SearchEngine::searchRoot(int depth)
+void SearchEngine::initRootMoves()
+{
+	MoveList list(historyHeuristicTable_.data());
+	int n = board_->generateAllMovesNoncheck<GENERAL>(list);
+	list.sort();
+
+	rootMoves_.clear();
+	for (int i = 0; i < n; ++i)
+		rootMoves_.push_back({ list.moves[i].move, -MATE_VALUE, 0 });
+}
+
+template <MakeMovePolicy policy, SideType us>
+int SearchEngine::searchRoot(int depth, int value_alpha, int value_beta)
 {
+	constexpr SideType them = (SideType)(1 - us);
 	int value = 0;
 	int value_best = -MATE_VALUE;
-	int mv = 0;
 	int new_depth = 0;
 
-	int mvs[MAX_GENERATE_MOVES];
-	int n = board_->generateAllMoves<GENERAL>(mvs);
-	std::sort(mvs, mvs + n, CompareByHistory(this));
+	for (RootMove& root : rootMoves_)
+		root.value = -MATE_VALUE;
 
-	for(int i = 0; i < n; ++i)
+	for (RootMove& root : rootMoves_)
 	{
-		int mv = mvs[i];
-		if (!makeMove(mv))
+		Move mv = root.mv;
+		int nodes = allNodes_;
+		if (!makeMove<policy>(mv))
 			continue;
 
 		//将军延伸(即将军的走法应该让它多搜索一层)
-		new_depth = board_->willKillSelfKing() ? depth : depth - 1;
+		new_depth = board_->inCheck() ? depth : depth - 1;
 
 		// PVS算法
 		// 先对第一个走法做全窗口搜索
 		if (value_best == -MATE_VALUE)
 		{
-			value = -searchFull(-MATE_VALUE, MATE_VALUE, new_depth, 1);
+			value = -searchFull<policy, them>(-value_beta, -value_alpha, new_depth, 1);
 		}
 		else
 		{
-			// 根据对第一个走法做全窗口搜索得到的下边界的值，对剩余的走法做零窗口搜索
-			value = -searchFull(-value_best-1, -value_best, new_depth, 0);
+			// 根据当前的下边界，对剩余的走法做零窗口搜索
+			value = -searchFull<policy, them>(-value_alpha - 1, -value_alpha, new_depth, 0);
 
 			// 检验零窗口搜索, 搜索失败则再对其进行全窗口搜索
-			if (value > value_best)
+			if (value > value_alpha && value < value_beta)
 			{
-				value = -searchFull(-MATE_VALUE, -value_best, new_depth, 1);
+				value = -searchFull<policy, them>(-value_beta, -value_alpha, new_depth, 1);
 			}
 		}
-		undoMove();
+		undoMove<policy>();
+		if (stopped())
+			return 0;
+
+		root.nodes = allNodes_ - nodes;
 		if (value > value_best)
 		{
 			value_best = value;
-			mvBest_ = mv;
+			// 低于窗口的走法分值只是上界，不更新最佳走法
+			if (value > value_alpha)
+			{
+				root.value = value;
+				mvBest_ = mv;
+				value_alpha = value;
+				if (value >= value_beta)
+					break;
+			}
 		}
 	}
 
-	setBestMove(mvBest_, depth);
+	// 下一次迭代先搜最佳走法，其余按子树节点数从多到少
+	std::stable_sort(rootMoves_.begin(), rootMoves_.end(), [](const RootMove& left, const RootMove& right)
+			{
+				if (left.value != right.value)
+					return left.value > right.value;
+				return left.nodes > right.nodes;
+			});
+
+	if (mvBest_)
+		setBestMove(mvBest_, depth);
 
 	return value_best;
 }
 
-int SearchEngine::search(int milliseconds)
+template <MakeMovePolicy policy>
+int SearchEngine::searchAspiration(int depth, int value)
 {
-	uint32_t checksum = board_->getZobrist().lock2_;
-	uint32_t mirrorChecksum = board_->getMirrorZobrist().lock2_;
-	int mv = openBook_.findBestMove(checksum, mirrorChecksum);
-	if (mv != 0 && makeMove(mv))// && repetitionValue(board_->repetitionStatus(3)) == 0)
+	int delta = ASPIRATION_WINDOW;
+	int value_alpha = -MATE_VALUE;
+	int value_beta = MATE_VALUE;
+	if (depth >= ASPIRATION_DEPTH && value > -WIN_VALUE && value < WIN_VALUE)
 	{
-		printf("find best mv in openbook:%d\n", mv);
-		undoMove();
-		return mv;
+		value_alpha = value - delta;
+		value_beta = value + delta;
 	}
 
-	reset();
+	for (;;)
+	{
+		value = board_->currentSide() == SIDE_TYPE_RED ?
+			searchRoot<policy, SIDE_TYPE_RED>(depth, value_alpha, value_beta) :
+			searchRoot<policy, SIDE_TYPE_BLACK>(depth, value_alpha, value_beta);
+		if (stopped())
+			return value;
+
+		delta *= 4;
+		if (value <= value_alpha && value_alpha > -MATE_VALUE)
+			value_alpha = std::max(value - delta, -MATE_VALUE);
+		else if (value >= value_beta && value_beta < MATE_VALUE)
+			value_beta = std::min(value + delta, MATE_VALUE);
+		else
+			return value;
+	}
+}
+
+template <MakeMovePolicy policy>
+int SearchEngine::search(int milliseconds, int maxDepth)
+{
+	// 开局库命中时也要让allNodes()返回本次搜索的节点数
+	allNodes_ = 0;
+	uint32_t checksum = board_->getZobrist().lock_;
+	uint32_t mirrorChecksum = board_->getMirrorZobrist().lock_;
+	Move mv(openBook_.findBestMove(checksum, mirrorChecksum));
+	if (mv && makeMove<policy>(mv))// && repetitionValue(board_->repetitionStatus(3)) == 0)
+	{
+		if (verbose_)
+			printf("find best mv in openbook:%d\n", mv.value());
+		undoMove<policy>();
+		return mv.value();
+	}
+
+	prepareSearch();
+	initRootMoves();
 	uint64_t t = now();
+
+	// 辅助线程从主线程的局面开始，各自迭代加深，直到主线程搜索结束
+	stopHelpers_.store(false, std::memory_order_relaxed);
+	std::vector<std::thread> workers;
+	for (auto& helper : helpers_)
+	{
+		helper->board_->copyFrom(*board_);
+		helper->quiescenceChecks_ = quiescenceChecks_;
+		SearchEngine* engine = helper.get();
+		workers.emplace_back([engine, maxDepth]() { engine->helperSearch<policy>(maxDepth); });
+	}
+
 	int value = 0;
 	// iterative deepening 迭代加深
-	for (int depth = 1; depth <= LIMIT_DEPTH; ++depth)
+	for (int depth = 1; depth <= maxDepth; ++depth)
 	{
 		ndepth_ = 0;
-		value = searchRoot(depth);
+		value = searchAspiration<policy>(depth, value);
+		completedDepth_ = depth;
+		completedMove_ = mvBest_;
 
 		uint64_t spendTime = now() - t;
 
-		printf("搜索[%2d]层数(real: %3d)\t<best mv>: %6d\t", depth, ndepth_, mvBest_);
-		uint64_t nps = (uint64_t)allNodes_ * 1000 * 1000 / spendTime;
-		printf("<spend time>: %5lu\t<all nodes>: %10d\t<speed>: %7lu nodes per second\n", 
-					 spendTime / 1000, allNodes_, nps);
+		if (verbose_)
+		{
+			printf("搜索[%2d]层数(real: %3d)\t<best mv>: %6d\t", depth, ndepth_, mvBest_.value());
+			uint64_t nps = spendTime ? (uint64_t)allNodes_ * 1000 * 1000 / spendTime : 0;
+			printf("<spend time>: %5lu\t<all nodes>: %10d\t<speed>: %7lu nodes per second\n", 
+						 spendTime / 1000, allNodes_, nps);
+		}
 		if (spendTime / 1000 >= milliseconds)
 		{
 				/*
-				printf("搜索层数：%d(real: %d), best mv: %d\n", depth, ndepth_, mvBest_);
+				printf("搜索层数：%d(real: %d), best mv: %d\n", depth, ndepth_, mvBest_.value());
 				uint64_t nps = (uint64_t)allNodes_ * 1000 / spendTime;
 				printf("info spend time: %lu, all nodes: %d, speed: %lu nodes per second\n\n", 
 							 spendTime, allNodes_, nps);
@@ -538,15 +676,73 @@ int SearchEngine::search(int milliseconds)
 		// 搜索到杀棋，就终止搜索
 		if (value > WIN_VALUE || value < -WIN_VALUE)
 		{
-			if (value > WIN_VALUE)
-				printf("已搜索到必胜之棋!mv=%d\n\n", mvBest_);
-			else
-				printf("已搜索到必输之棋!mv=%d\n\n", mvBest_);
+			if (verbose_)
+			{
+				if (value > WIN_VALUE)
+					printf("已搜索到必胜之棋!mv=%d\n\n", mvBest_.value());
+				else
+					printf("已搜索到必输之棋!mv=%d\n\n", mvBest_.value());
+			}
 			break;
 		}
 	}
 
-	return mvBest_;
+	stopHelpers_.store(true, std::memory_order_relaxed);
+	for (std::thread& worker : workers)
+		worker.join();
+
+	// 取完整搜索层数最深的线程的最佳走法，层数相同时以主线程为准
+	for (auto& helper : helpers_)
+	{
+		allNodes_ += helper->allNodes_;
+		if (helper->completedDepth_ > completedDepth_ && helper->completedMove_)
+		{
+			completedDepth_ = helper->completedDepth_;
+			completedMove_ = helper->completedMove_;
+		}
+	}
+	mvBest_ = completedMove_;
+	if (verbose_ && !helpers_.empty())
+	{
+		uint64_t spendTime = now() - t;
+		printf("%d个线程，最深完成[%2d]层\t<best mv>: %6d\t<all nodes>: %10d\t<speed>: %7lu nodes per second\n",
+				threads(), completedDepth_, mvBest_.value(), allNodes_,
+				spendTime ? (uint64_t)allNodes_ * 1000 * 1000 / spendTime : 0);
+	}
+
+	return mvBest_.value();
+}
+template int SearchEngine::search<MAKE_UNMAKE>(int milliseconds, int maxDepth);
+template int SearchEngine::search<COPY_MAKE>(int milliseconds, int maxDepth);
+
+template <MakeMovePolicy policy>
+void SearchEngine::helperSearch(int maxDepth)
+{
+	prepareSearch();
+	initRootMoves();
+	int value = 0;
+	for (int depth = 1 + (helperId_ & 1); depth <= maxDepth; ++depth)
+	{
+		ndepth_ = 0;
+		value = searchAspiration<policy>(depth, value);
+		if (stopped())
+			break;
+		completedDepth_ = depth;
+		completedMove_ = mvBest_;
+		if (value > WIN_VALUE || value < -WIN_VALUE)
+			break;
+	}
+}
+
+void SearchEngine::setThreads(int threads)
+{
+	threads = std::max(1, threads);
+	helpers_.resize(threads - 1);
+	for (int i = 0; i < threads - 1; ++i)
+	{
+		if (!helpers_[i])
+			helpers_[i].reset(new SearchEngine(this, i + 1));
+	}
 }
 
 } // namespace cppupdate
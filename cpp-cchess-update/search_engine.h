@@ -1,9 +1,13 @@
 #ifndef __WSUN_CCHESS_CPP_UPDATE_SEARCH_ENGINE_H__
 #define __WSUN_CCHESS_CPP_UPDATE_SEARCH_ENGINE_H__
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <inttypes.h>
 #include "board.h"
+#include "transposition_table.h"
 #include <time.h>
 
 namespace wsun
@@ -13,11 +17,10 @@ namespace cchess
 namespace cppupdate
 {
 
-#define MAX_GENERATE_MOVES 128
 #define LIMIT_DEPTH 64 // 最大的搜索深度
 #define HISTORY_HEURISTIC_TABLE_SIZE (1 << 16)
-#define TRANSPOSITION_TABLE_SIZE (1ul << 20)
-//static const size_t TRANSPOSITION_TABLE_SIZE = (1ul << 32);
+// 两次搜索之间历史表的分值右移的位数
+#define HISTORY_AGING_SHIFT 2
 
 //static const char* OPENBOOK_FILE_PATH = "../cchess-cpp-release/BOOK.DAT";
 static const char* OPENBOOK_FILE_PATH = "./BOOK.DAT";
@@ -33,15 +36,15 @@ static const int NULL_SAFE_MARGIN = 400;
 static const int NULL_OKAY_MARGIN = 200;
 static const int NULL_DEPTH = 2;
 
-struct tt_item
-{
-	uint8_t depth;	// 深度
-	uint8_t flag;		// alpha、beta、pv 三种节点类型
-	int value;			// 局面分数值
-	int mv;					// 走法
-	uint32_t checksum_lower32;  // 局面zobrist校验值checksum 64位
-	uint32_t checksum_higher32; 
-};
+// 渴望窗口：从这一层开始以上一层的分值为中心开窗口，失败时窗口向失败的一侧按倍数放宽
+static const int ASPIRATION_DEPTH = 4;
+static const int ASPIRATION_WINDOW = 30;
+
+// 静态搜索的delta裁剪余量
+static const int QUIESC_DELTA_MARGIN = 50;
+
+// 搜索默认的走棋方式
+static const MakeMovePolicy DEFAULT_MAKE_MOVE_POLICY = MAKE_UNMAKE;
 
 // 开局库
 class OpenBook
@@ -55,6 +58,7 @@ public:
 		uint16_t value_;
 	};
 
+	OpenBook() {}
 	explicit OpenBook(const char* filePath)
 	{
 		load(filePath);
@@ -132,34 +136,116 @@ private:
 	std::vector<BookItem> bookItems_; // 按照校验值进行有序排列的
 };
 
+// 根节点走法，保存上一次迭代的分值和子树节点数，用来给下一次迭代排序
+struct RootMove
+{
+	Move mv;
+	int value;		// 只有改进了最佳分值的走法才有准确分值，其余为-MATE_VALUE
+	int nodes;
+};
+
 class SearchEngine
 {
 public:
-	SearchEngine(Board* board) : board_(board), openBook_(OPENBOOK_FILE_PATH) { }
+	SearchEngine(Board* board)
+		: board_(board),
+			transpositionTable_(&transpositionTableStorage_),
+			openBook_(OPENBOOK_FILE_PATH)
+	{
+		transpositionTableStorage_.resize(DEFAULT_HASH_MB);
+		historyHeuristicTable_.fill(0);
+	}
+
+	// 清空置换表、历史表和杀手表，开始新的一局时调用
 	void reset()
 	{
-		distance_ = 0;
-		allNodes_ = 0;
-		mvBest_ = 0;
-		ndepth_ = 0;
 		historyHeuristicTable_.fill(0);
-		memset(killerHeuristicTable_, 0, LIMIT_DEPTH * 2);
-		transpositionTable_.fill({0,0,0,0,0,0});
+		prepareSearch();
+		if (!stop_)
+			transpositionTable_->clear();
 	}
 
-	int search(int milliseconds);
+	// 置换表大小(MB)，重新分配并清空，不能在搜索过程中调用
+	void setHashSize(size_t megabytes) { transpositionTable_->resize(megabytes); }
+	size_t hashSize() const { return transpositionTable_->megabytes(); }
+
+	// 静态搜索的第一层是否也搜索不吃子的将军着法，默认关闭
+	void setQuiescenceChecks(bool checks) { quiescenceChecks_ = checks; }
+	bool quiescenceChecks() const { return quiescenceChecks_; }
+
+	// 搜索线程数(Lazy SMP)：除了调用search的主线程，另外启动threads - 1个辅助线程，
+	// 每个辅助线程有自己的棋盘、历史表和杀手表，共用主线程的置换表
+	void setThreads(int threads);
+	int threads() const { return (int)helpers_.size() + 1; }
+
+	// 迭代加深搜索，到达时间或者深度maxDepth后返回最佳着法，
+	// policy为搜索树中走棋和撤销的方式(make/unmake或者copy-make)
+	template <MakeMovePolicy policy>
+	int search(int milliseconds, int maxDepth = LIMIT_DEPTH);
+	int search(int milliseconds, int maxDepth = LIMIT_DEPTH)
+	{
+		return search<DEFAULT_MAKE_MOVE_POLICY>(milliseconds, maxDepth);
+	}
+
+	// 按"position"命令的参数增量同步要搜索的局面，见Board::syncPosition
+	int syncPosition(const char* command) { return board_->syncPosition(command); }
+
+	// 上一次搜索所有线程的节点数之和
+	int allNodes() const { return allNodes_; }
+	// 是否打印每一层的搜索信息
+	void setVerbose(bool verbose) { verbose_ = verbose; }
 
 	const std::array<int, HISTORY_HEURISTIC_TABLE_SIZE>&
 		getHistoryHeuristicTable() const { return historyHeuristicTable_; }
 
 	Board* board() const { return board_; }
-	int getKillerMove(int which) const
+	Move getKillerMove(int which) const
 	{
 		//return 1;
 		return killerHeuristicTable_[distance_][which];
 	}
 
 private:
+	// 辅助线程，与主线程共用置换表，搜索结束时由主线程通知停止
+	SearchEngine(SearchEngine* main, int id)
+		: ownBoard_(new Board),
+			board_(ownBoard_.get()),
+			transpositionTable_(main->transpositionTable_),
+			stop_(&main->stopHelpers_),
+			helperId_(id)
+	{
+		verbose_ = false;
+		historyHeuristicTable_.fill(0);
+	}
+
+	// 每次搜索开始时调用。置换表不清空，只增加代数，上一步留下的条目仍然可以命中，
+	// 替换时优先被淘汰；历史表缩小而不清零，保留上一步学到的走法顺序；杀手表按层清空
+	void prepareSearch()
+	{
+		distance_ = 0;
+		allNodes_ = 0;
+		mvBest_ = Move();
+		ndepth_ = 0;
+		completedDepth_ = 0;
+		completedMove_ = Move();
+		for (int& value : historyHeuristicTable_)
+			value >>= HISTORY_AGING_SHIFT;
+		std::fill(&killerHeuristicTable_[0][0], &killerHeuristicTable_[0][0] + LIMIT_DEPTH * 2, Move());
+		// 代数由主线程增加，辅助线程共用
+		if (!stop_)
+			transpositionTable_->newSearch();
+	}
+
+	// 辅助线程被通知停止之后，搜索函数不再使用子节点的结果，直接逐层返回
+	bool stopped() const
+	{
+		return stop_ && stop_->load(std::memory_order_relaxed);
+	}
+
+	// 辅助线程的迭代加深，编号为奇数的线程比主线程深一层，错开搜索深度
+	template <MakeMovePolicy policy>
+	void helperSearch(int maxDepth);
+
 	int mateValue() const { return distance_ - MATE_VALUE; }
 	int banValue() const { return distance_ - BAN_VALUE; }
 	int drawValue() const 
@@ -167,19 +253,21 @@ private:
 		return (distance_ & 1) == 0  ? -DRAW_VALUE : DRAW_VALUE;
 	}
 
+	template <SideType us>
 	bool nullOkay() const
 	{
-		return board_->currentSidePlayer()->value() > NULL_OKAY_MARGIN;
+		return board_->sideValue(us) > NULL_OKAY_MARGIN;
 	}
+	template <SideType us>
 	bool nullSafe() const
 	{
-		return board_->currentSidePlayer()->value() > NULL_SAFE_MARGIN;
+		return board_->sideValue(us) > NULL_SAFE_MARGIN;
 	}
 
-	void setBestMove(int mv, int depth)
+	void setBestMove(Move mv, int depth)
 	{
-		historyHeuristicTable_[mv] += depth * depth;
-		int* killer_table = killerHeuristicTable_[depth];
+		historyHeuristicTable_[mv.value()] += depth * depth;
+		Move* killer_table = killerHeuristicTable_[depth];
 		if (mv == killer_table[0])
 		{
 			killer_table[1] = killer_table[0];
@@ -201,12 +289,13 @@ private:
 		board_->changeSide();
 	}
 
-	bool makeMove(int mv)
+	template <MakeMovePolicy policy>
+	bool makeMove(Move mv)
 	{
-		board_->makeMove(mv);
-		if(board_->willKillSelfKing())
+		board_->makeMove<policy>(mv);
+		if (board_->movedIntoCheck())
 		{
-			board_->undoMove();
+			board_->undoMove<policy>();
 			return false;
 		}
 		++distance_;
@@ -214,10 +303,13 @@ private:
 		return true;
 	}
 
+	// copy-make弹出局面栈时下棋方也一起恢复了，不需要再换边
+	template <MakeMovePolicy policy>
 	void undoMove()
 	{
-		board_->undoMove();
-		board_->changeSide();
+		board_->undoMove<policy>();
+		if (policy == MAKE_UNMAKE)
+			board_->changeSide();
 		--distance_;
 	}
 
@@ -228,24 +320,46 @@ private:
 		return (vl == 0 ? drawValue() : vl);
 	}
 
-	int transpositionTableGrab(int vlAlpha, int vlBeta, int depth, int* mv);
-	void transpositionTableInsert(int flag, int value, int depth, int mv);
+	int transpositionTableGrab(int vlAlpha, int vlBeta, int depth, Move* mv);
+	void transpositionTableInsert(int flag, int value, int depth, Move mv);
 
-	int searchQuiescence(int valueAlpha, int valueBeta);
+	// 搜索函数按下棋方us在编译期特化，走一步之后调用对方(1 - us)的版本
+	// checks为true时除了吃子还搜索不吃子的将军着法，只用于静态搜索的第一层
+	template <MakeMovePolicy policy, SideType us>
+	int searchQuiescence(int valueAlpha, int valueBeta, bool checks);
+	template <MakeMovePolicy policy, SideType us>
 	int searchFull(int valueAlpha, int valueBeta, int depth, int nonull);
-	int searchRoot(int depth);
+	template <MakeMovePolicy policy, SideType us>
+	int searchRoot(int depth, int valueAlpha, int valueBeta);
+	// 用渴望窗口搜索一层，value为上一层的分值，窗口外失败时放宽窗口重新搜索
+	template <MakeMovePolicy policy>
+	int searchAspiration(int depth, int value);
+	// 生成根节点走法，初始按历史表排序
+	void initRootMoves();
 	
 private:
+	std::unique_ptr<Board> ownBoard_;	// 辅助线程自己的棋盘
 	Board* board_;
 	int distance_;
 	int ndepth_;
 	int allNodes_;
-	int mvBest_;
+	Move mvBest_;
+	std::vector<RootMove> rootMoves_;
+	bool verbose_ = true;
+	bool quiescenceChecks_ = false;
 	std::array<int, HISTORY_HEURISTIC_TABLE_SIZE> historyHeuristicTable_;
-	int killerHeuristicTable_[LIMIT_DEPTH][2];
-	std::array<tt_item, TRANSPOSITION_TABLE_SIZE> transpositionTable_;
+	Move killerHeuristicTable_[LIMIT_DEPTH][2];
+	TranspositionTable transpositionTableStorage_;	// 只有主线程分配
+	TranspositionTable* transpositionTable_;
 
 	OpenBook openBook_;
+
+	std::vector<std::unique_ptr<SearchEngine>> helpers_;
+	std::atomic<bool> stopHelpers_{false};
+	const std::atomic<bool>* stop_ = nullptr;	// 辅助线程指向主线程的stopHelpers_
+	int helperId_ = 0;
+	int completedDepth_ = 0;		// 已完整搜索的层数及其最佳走法
+	Move completedMove_;
 };
 
 } // namespace cppupdate
@@ -1,28 +1,67 @@
 #include "../board.h"
 #include <assert.h>
 #include <stdio.h>
+#include <inttypes.h>
 #include <memory>
+#include <string.h>
 
 using wsun::cchess::cppupdate::Board;
+using wsun::cchess::cppupdate::iccs_move_to_move;
 int main(int argc, char **argv)
 {
 	std::unique_ptr<Board> b(new Board);
-	int mvs[128];
-	int n = b->generateAllMovesNoncheck<wsun::cchess::cppupdate::GENERAL>(mvs);
+	wsun::cchess::cppupdate::MoveList list;
+	int n = b->generateAllMovesNoncheck<wsun::cchess::cppupdate::GENERAL>(list);
 	assert(n > 0);
-	printf("zobrist key: %u\n", b->getZobrist().key_);
-	b->play(mvs[0]);
-	printf("zobrist key: %u\n", b->getZobrist().key_);
+	uint64_t key = b->getZobrist().key_;
+	int redValue = b->sideValue(wsun::cchess::cppupdate::SIDE_TYPE_RED);
+	int blackValue = b->sideValue(wsun::cchess::cppupdate::SIDE_TYPE_BLACK);
+	printf("zobrist key: %" PRIu64 "\n", b->getZobrist().key_);
+	b->play(list.moves[0].move);
+	uint64_t playedKey = b->getZobrist().key_;
+	printf("zobrist key: %" PRIu64 "\n", b->getZobrist().key_);
 	b->makeNullMove();
 
 	b->changeSide();
 
-	printf("zobrist key: %u\n", b->getZobrist().key_);
+	printf("zobrist key: %" PRIu64 "\n", b->getZobrist().key_);
 	b->undoNullMove();
 	b->changeSide();
-	printf("zobrist key: %u\n", b->getZobrist().key_);
+	printf("zobrist key: %" PRIu64 "\n", b->getZobrist().key_);
+	assert(b->getZobrist().key_ == playedKey);
 	b->backOneStep();
-	printf("zobrist key: %u\n", b->getZobrist().key_);
+	printf("zobrist key: %" PRIu64 "\n", b->getZobrist().key_);
+	assert(b->getZobrist().key_ == key);
+	assert(b->sideValue(wsun::cchess::cppupdate::SIDE_TYPE_RED) == redValue);
+	assert(b->sideValue(wsun::cchess::cppupdate::SIDE_TYPE_BLACK) == blackValue);
+
+	// 炮打马之后撤销，被吃掉的马要回到棋子列表中原来的位置
+	const wsun::cchess::cppupdate::Position before = b->position();
+	b->play("b2b9");
+	assert(b->position().pieceCount(wsun::cchess::cppupdate::SIDE_TYPE_BLACK, wsun::cchess::cppupdate::PIECE_TYPE_KNIGHT) == 1);
+	b->backOneStep();
+	for (int side = 0; side < 2; ++side)
+	{
+		for (int type = 0; type < wsun::cchess::cppupdate::PIECE_TYPE_NUMBER; ++type)
+		{
+			int count = before.pieceCount(side, type);
+			assert(b->position().pieceCount(side, type) == count);
+			assert(memcmp(b->position().pieceList(side, type), before.pieceList(side, type), count) == 0);
+		}
+	}
+
+	// copy-make走棋后的局面与make/unmake一致，撤销时弹出局面栈回到原来的局面
+	b->makeMove<wsun::cchess::cppupdate::COPY_MAKE>(wsun::cchess::cppupdate::Move(iccs_move_to_move("b2b9")));
+	uint64_t copyKey = b->getZobrist().key_;
+	b->makeMove<wsun::cchess::cppupdate::COPY_MAKE>(wsun::cchess::cppupdate::Move(iccs_move_to_move("a9b9")));
+	b->undoMove<wsun::cchess::cppupdate::COPY_MAKE>();
+	assert(b->getZobrist().key_ == copyKey);
+	b->undoMove<wsun::cchess::cppupdate::COPY_MAKE>();
+	assert(b->getZobrist().key_ == key);
+	assert(memcmp(&b->position(), &before, sizeof(before)) == 0);
+	b->makeMove(wsun::cchess::cppupdate::Move(iccs_move_to_move("b2b9")));
+	assert(b->getZobrist().key_ == copyKey);
+	b->undoMove();
 
 	return 0;
 }
@@ -0,0 +1,143 @@
+#include "../board.h"
+#include "../epd_reader.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace ::wsun::cchess::cppupdate;
+
+// fen串写到缓冲区再解析回来，局面必须完全一致；
+// 再把一组局面写到临时EPD文件中，验证批量读取的局面和EPD操作；
+// 最后验证"position fen + moves"的增量同步与完整重置得到的局面一致
+
+static const char* fens[] = {
+	"rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR w",
+	"r1ba1a3/4kn3/2n1b4/pNp1p1p1p/4c4/6P2/P1P2R2P/1CcC5/9/2BAKAB2 w",
+	"2bak4/4a4/4b4/9/2p3n2/6P2/9/4B4/4A4/2RAK4 w",
+	"3k5/9/9/9/9/9/9/9/4p4/3K5 b",
+};
+
+static void check_same_board(const Board& a, const Board& b)
+{
+	assert(a.currentSide() == b.currentSide());
+	assert(a.getZobrist().key_ == b.getZobrist().key_);
+	assert(a.getZobrist().lock_ == b.getZobrist().lock_);
+	assert(a.sideValue(SIDE_TYPE_RED) == b.sideValue(SIDE_TYPE_RED));
+	assert(a.sideValue(SIDE_TYPE_BLACK) == b.sideValue(SIDE_TYPE_BLACK));
+}
+
+int main()
+{
+	const int n = sizeof(fens) / sizeof(fens[0]);
+	Board board;
+	Board other;
+	char buffer[MAX_FEN_LENGTH];
+
+	// 缓冲区不够时不写入
+	assert(board.toFen(buffer, MAX_FEN_LENGTH - 1) == 0);
+
+	for (int i = 0; i < n; ++i)
+	{
+		board.resetFromFen(fens[i]);
+		int len = board.toFen(buffer, sizeof(buffer));
+		assert(len > 0 && len == (int)strlen(buffer));
+		assert(strncmp(buffer, fens[i], strlen(fens[i])) == 0);
+		assert(board.toFen() == buffer);
+
+		// 只解析[buffer, buffer + len)，不依赖结尾的'\0'
+		other.resetFromFen(buffer, buffer + len);
+		check_same_board(board, other);
+	}
+
+	// 走几步之后，计数也要正确输出
+	board.reset();
+	board.play("h2e2");
+	board.play("h9g7");
+	board.toFen(buffer, sizeof(buffer));
+	assert(strcmp(buffer, "rnbakab1r/9/1c4nc1/p1p1p1p1p/9/9/P1P1P1P1P/1C2C4/9/RNBAKABNR w - - 2 2") == 0);
+
+	char path[] = "/tmp/fen_unittest_XXXXXX";
+	int fd = mkstemp(path);
+	assert(fd >= 0);
+	FILE* fp = fdopen(fd, "w");
+	fprintf(fp, "# comment line\n\n");
+	for (int i = 0; i < n; ++i)
+	{
+		// 最后一行没有换行符
+		fprintf(fp, "%s bm h2e2; id \"%d\";%s", fens[i], i, i + 1 < n ? "\r\n" : "");
+	}
+	fclose(fp);
+
+	EpdReader reader(path);
+	assert(reader.isOpen());
+	for (int round = 0; round < 2; ++round)
+	{
+		int count = 0;
+		const char* ops = nullptr;
+		int opsLength = 0;
+		while (reader.next(board, &ops, &opsLength))
+		{
+			char expected[32];
+			int expectedLength = sprintf(expected, "bm h2e2; id \"%d\";", count);
+			assert(opsLength == expectedLength && memcmp(ops, expected, opsLength) == 0);
+
+			other.resetFromFen(fens[count]);
+			check_same_board(board, other);
+			++count;
+		}
+		assert(count == n);
+		reader.rewind();
+	}
+	unlink(path);
+
+	EpdReader missing("/nonexistent/fen_unittest.epd");
+	assert(!missing.isOpen());
+	assert(!missing.next(board));
+
+	// 每次只多一步的增量同步，历史着法保留下来，可以检测到重复局面
+	static const char* cycle[] = { "h2e2", "h9g7", "e2h2", "g7h9" };
+	char command[256] = "startpos moves";
+	board.reset();
+	assert(board.syncPosition(command) == 0);
+	for (int i = 0; i < 8; ++i)
+	{
+		strcat(command, " ");
+		strcat(command, cycle[i % 4]);
+		assert(board.syncPosition(command) == i + 1);
+		other.reset();
+		for (int j = 0; j <= i; ++j)
+			other.play(cycle[j % 4]);
+		check_same_board(board, other);
+	}
+	assert(board.repetitionStatus(1) != 0);
+
+	// 着法与历史不同时完整重置
+	assert(board.syncPosition("startpos moves h2e2 b9c7") == 2);
+	other.reset();
+	other.play("h2e2");
+	other.play("b9c7");
+	check_same_board(board, other);
+	assert(board.repetitionStatus(1) == 0);
+
+	// 带计数的fen串，起始局面相同时继续增量同步
+	snprintf(command, sizeof(command), "fen %s b - - 0 1 moves h9g7", "rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C2C4/9/RNBAKABNR");
+	assert(board.syncPosition(command) == 1);
+	strcat(command, " h0g2");
+	assert(board.syncPosition(command) == 2);
+	other.resetFromFen("rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C2C4/9/RNBAKABNR b");
+	other.play("h9g7");
+	other.play("h0g2");
+	check_same_board(board, other);
+
+	// 不合法的着法之后的部分被忽略，格式错误时局面不变
+	assert(board.syncPosition("startpos moves h2e2 h2e2") == 1);
+	assert(board.syncPosition("position startpos") == -1);
+	assert(board.syncPosition("startpos") == 0);
+	other.reset();
+	check_same_board(board, other);
+
+	printf("fen unittest passed\n");
+	return 0;
+}
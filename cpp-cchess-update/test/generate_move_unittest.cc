@@ -9,11 +9,11 @@ using namespace ::wsun::cchess::cppupdate;
 // 自己跟自己对弈，每一步都是随机从生成的所有走法中选的，
 // 然后将棋盘做镜像处理，验证镜像棋盘局面所生成的走法与原走法数相同
 
-static int get_rand_move(Board* board, int* mvs, const int size)
+static Move get_rand_move(Board* board, const MoveList& list, const int size)
 {
 	if (size == 1)
 	{
-		return mvs[0];
+		return list.moves[0].move;
 	}
 
 	int array[size];
@@ -23,13 +23,13 @@ static int get_rand_move(Board* board, int* mvs, const int size)
 		array[i] = 0;
 	}
 
-	int mv = 0;
+	Move mv = Move();
 	while (total != size)
 	{
 		int idx = rand() % size;
 		if (array[idx]) continue;
 
-		mv = mvs[idx];
+		mv = list.moves[idx].move;
 		board->play(mv);
 		if (board->repetitionStatus(1) == 0)
 		{
@@ -40,31 +40,111 @@ static int get_rand_move(Board* board, int* mvs, const int size)
 		array[idx] = 1;
 		++total;
 	}
-	return total == size ? 0 : mv;
+	return total == size ? Move() : mv;
+}
+
+// 任意起点、终点(包括棋盘外的终点)组成的走法，isPseudoLegal的结果必须与伪合法走法生成器一致
+static void check_pseudo_legal(Board* board)
+{
+	MoveList list;
+	board->generateAllMoves<GENERAL>(list);
+	for (int start = 0; start < 256; ++start)
+	{
+		if (!in_board(start)) continue;
+		for (int end = 0; end < 256; ++end)
+		{
+			if (end == start) continue;
+			Move mv(start, end);
+			assert(board->isPseudoLegal(mv) == list.contains(mv));
+		}
+	}
+}
+
+// 攻击表必须与反向计算的结果一致；对方棋子所在的位置被攻击，
+// 当且仅当有棋子可以按走法规则吃掉它，帅(将)被攻击当且仅当被将军
+static void check_attack_maps(Board* board)
+{
+	const Position& position = board->position();
+	for (int pos = 0; pos < 256; ++pos)
+	{
+		if (!in_board(pos)) continue;
+		assert(position.attackers(pos) == position.computeAttackers(pos));
+		int target = position.pieceAt(pos);
+		if (!target) continue;
+
+		uint32_t expected = 0;
+		for (int pc = 16; pc < 48; ++pc)
+		{
+			int from = position.piecePos(pc);
+			if (from && side_of_piece(pc) != side_of_piece(target) &&
+					legalMoveByType(position, position.pieceType(pc), from, pos))
+				expected |= 1u << (pc - 16);
+		}
+		assert(position.attackers(pos, 1 - side_of_piece(target)) == expected);
+	}
+	for (int side = 0; side < 2; ++side)
+	{
+		int kingPos = position.kingPos(side);
+		assert(!kingPos || position.attacked(kingPos, 1 - side) == position.checked(side));
+	}
+}
+
+// 不走棋判断的将军必须与走完之后对方是否被将军一致
+static void check_gives_check(Board* board)
+{
+	MoveList list;
+	int n = board->generateAllMoves<GENERAL>(list);
+	int side = board->currentSide();
+	for (int i = 0; i < n; ++i)
+	{
+		Move mv = list.moves[i].move;
+		bool gives = board->givesCheck(mv);
+		board->makeMove(mv);
+		assert(gives == board->position().checked(1 - side));
+		board->undoMove();
+	}
+}
+
+// 逐个走棋再撤销来统计合法走法数，用于验证合法走法生成器
+static int count_legal_moves_by_make(Board* board)
+{
+	MoveList list;
+	int nums = 0;
+	int n = board->generateAllMoves<GENERAL>(list);
+	for (int i = 0; i < n; ++i)
+	{
+		board->makeMove(list.moves[i].move);
+		if (!board->willKillSelfKing())
+		{
+			++nums;
+		}
+		board->undoMove();
+	}
+	return nums;
 }
 
 int main()
 {
 	srand(time(NULL));
-	int mvs[128];
-	int capatured_mvs[128];
-	int mirror_mvs[128];
-	int mirror_capatured_mvs[128];
-	int exchange_mvs[128];
-	int exchange_capatured_mvs[128];
 	Board* board = new Board;
 	Board* mboard = nullptr;
 	Board* exchange_board = nullptr;
 
 	std::string fenString = board->toFen();
 	printf("fen: %s\n", fenString.c_str());
-	assert(board->currentSidePlayer()->value() == board->getOpponentPlayer()->value());
+	assert(board->sideValue(board->currentSide()) == board->sideValue(board->opponentSide()));
 
 	int round = 2;
 	int n =0;
 	//while ((n = generate_all_moves(board, mvs, 0)) > 0)
+	MoveList mvs;
 	while ((n = board->generateAllMovesNoncheck<GENERAL>(mvs)) > 0)
 	{
+		MoveList capatured_mvs;
+		MoveList mirror_mvs;
+		MoveList mirror_capatured_mvs;
+		MoveList exchange_mvs;
+		MoveList exchange_capatured_mvs;
 		//int capatured_n = generate_all_moves(board, capatured_mvs, 1);
 		int capatured_n = board->generateAllMovesNoncheck<GENERAL>(capatured_mvs);
 
@@ -83,37 +163,46 @@ int main()
 			char iccsmv[5] = {0};
 			for (int i = 0; i < n; ++i)
 			{
-				int start = start_of_move(mvs[i]);
-				move_to_iccs_move(iccsmv, mvs[i]);
-				printf("raw type: %d, %s\n", board->pieces()[start]->type(), iccsmv);
+				int start = mvs.moves[i].move.start();
+				move_to_iccs_move(iccsmv, mvs.moves[i].move.value());
+				printf("raw type: %d, %s\n", board->position().typeAt(start), iccsmv);
 			}
 			for (int i = 0; i < mirror_n; ++i)
 			{
-				int start = start_of_move(mvs[i]);
-				move_to_iccs_move(iccsmv, mvs[i]);
-				printf("mirror type: %d, %s\n", mboard->pieces()[start]->type(), iccsmv);
+				int start = mirror_mvs.moves[i].move.start();
+				move_to_iccs_move(iccsmv, mirror_mvs.moves[i].move.value());
+				printf("mirror type: %d, %s\n", mboard->position().typeAt(start), iccsmv);
 			}
 		}
 		
+		assert(n == count_legal_moves_by_make(board));
+		check_pseudo_legal(board);
+		check_gives_check(board);
+		check_attack_maps(board);
+		check_attack_maps(mboard);
+		assert(board->getMirrorZobrist().key_ == mboard->getZobrist().key_);
+		assert(board->getMirrorZobrist().lock_ == mboard->getZobrist().lock_);
+		assert(board->getZobrist().key_ == mboard->getMirrorZobrist().key_);
 		assert(n == mirror_n);
 		assert(capatured_n == mirror_capatured_n);
 		assert(n == exchange_n);
 		assert(capatured_n == exchange_capatured_n);
 
-		assert(board->currentSidePlayer()->value() == mboard->currentSidePlayer()->value());
-		assert(board->getOpponentPlayer()->value() == mboard->getOpponentPlayer()->value());
+		assert(board->sideValue(board->currentSide()) == mboard->sideValue(mboard->currentSide()));
+		assert(board->sideValue(board->opponentSide()) == mboard->sideValue(mboard->opponentSide()));
 		assert(board->evaluate() == mboard->evaluate());
 
-		assert(board->currentSidePlayer()->value() == exchange_board->currentSidePlayer()->value());
-		assert(board->getOpponentPlayer()->value() == exchange_board->getOpponentPlayer()->value());
+		assert(board->sideValue(board->currentSide()) == exchange_board->sideValue(exchange_board->currentSide()));
+		assert(board->sideValue(board->opponentSide()) == exchange_board->sideValue(exchange_board->opponentSide()));
 		assert(board->evaluate() == exchange_board->evaluate());
 
 		delete mboard;
 		delete exchange_board;
 
 		// 随机选一种走法
-		int mv = get_rand_move(board, mvs, n);
-		if (mv == 0) 
+		Move mv = get_rand_move(board, mvs, n);
+		mvs.size = 0;
+		if (!mv) 
 		{
 			printf("repeat situation, shutdown\n");
 			break;
@@ -121,12 +210,12 @@ int main()
 
     board->display();
 
-		assert(!board->pieces()[end_of_move(mv)] || board->pieces()[end_of_move(mv)]->type() != PIECE_TYPE_KING);
+		assert(board->position().typeAt(mv.end()) != PIECE_TYPE_KING);
 
 		board->play(mv);
 
 		char iccsmv[5] = {0};
-		move_to_iccs_move(iccsmv, mv);
+		move_to_iccs_move(iccsmv, mv.value());
 		if (round % 2 == 0)
 		{
 			printf("第%d回合: %s\n", round / 2, iccsmv);
@@ -0,0 +1,108 @@
+#include "../board.h"
+#include "../perft.h"
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+using namespace ::wsun::cchess::cppupdate;
+
+// perft [-d 深度] [-t 线程数] [-H 置换表MB] [-D] [-c] [fen]
+//   -D 按根走法分别输出节点数(divide)
+//   -c 用perft_positions中已知的节点数校验走法生成器，有不一致时返回1
+
+static uint64_t now_us()
+{
+	struct timeval tm;
+	gettimeofday(&tm, NULL);
+	return tm.tv_sec * 1000000 + tm.tv_usec;
+}
+
+static void usage(const char* name)
+{
+	printf("%s [-d depth] [-t threads] [-H hash_mb] [-D] [-c] [fen]\n", name);
+	exit(1);
+}
+
+static uint64_t run(Board& board, int depth, int threads, PerftHash* hash, bool showDivide)
+{
+	std::vector<PerftDivide> divide;
+	uint64_t start = now_us();
+	uint64_t nodes = perftDivide(board, depth, divide, threads, hash);
+	uint64_t spend = now_us() - start;
+
+	if (showDivide)
+	{
+		char iccs[5] = {0};
+		for (const PerftDivide& item : divide)
+		{
+			move_to_iccs_move(iccs, item.mv.value());
+			printf("%s: %" PRIu64 "\n", iccs, item.nodes);
+		}
+	}
+	printf("depth %d nodes %" PRIu64 " time %" PRIu64 "ms speed %" PRIu64 " nodes per second\n",
+			depth, nodes, spend / 1000, spend ? nodes * 1000000 / spend : 0);
+	return nodes;
+}
+
+int main(int argc, char** argv)
+{
+	int depth = 4;
+	int threads = 1;
+	size_t hashMB = 0;
+	bool showDivide = false;
+	bool check = false;
+	const char* fen = INIT_FEN_STRING;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-d") && i + 1 < argc)
+			depth = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-H") && i + 1 < argc)
+			hashMB = (size_t)atol(argv[++i]);
+		else if (!strcmp(argv[i], "-D"))
+			showDivide = true;
+		else if (!strcmp(argv[i], "-c"))
+			check = true;
+		else if (argv[i][0] != '-')
+			fen = argv[i];
+		else
+			usage(argv[0]);
+	}
+
+	std::unique_ptr<PerftHash> hash(hashMB ? new PerftHash(hashMB) : nullptr);
+	Board board;
+	if (!check)
+	{
+		board.resetFromFen(fen);
+		run(board, depth, threads, hash.get(), showDivide);
+		return 0;
+	}
+
+	int failed = 0;
+	for (int i = 0; i < perft_positions_size; ++i)
+	{
+		const PerftPosition& position = perft_positions[i];
+		printf("%s\n", position.fen);
+		board.resetFromFen(position.fen);
+		for (int d = 1; d <= depth && d <= 5; ++d)
+		{
+			uint64_t expected = position.nodes[d - 1];
+			if (!expected)
+				break;
+			if (hash)
+				hash->clear();
+			uint64_t nodes = run(board, d, threads, hash.get(), showDivide);
+			if (nodes != expected)
+			{
+				printf("mismatch: expected %" PRIu64 "\n", expected);
+				++failed;
+			}
+		}
+	}
+	printf(failed ? "perft check failed\n" : "perft check passed\n");
+	return failed ? 1 : 0;
+}
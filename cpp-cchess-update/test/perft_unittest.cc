@@ -0,0 +1,36 @@
+#include "../board.h"
+#include "../perft.h"
+#include <assert.h>
+#include <stdio.h>
+
+using namespace ::wsun::cchess::cppupdate;
+
+// 已知局面的perft节点数；divide的总和、置换表、多线程的结果都必须与单线程一致
+
+int main()
+{
+	Board board;
+	PerftHash hash(16);
+	std::vector<PerftDivide> divide;
+	for (int i = 0; i < perft_positions_size; ++i)
+	{
+		const PerftPosition& position = perft_positions[i];
+		board.resetFromFen(position.fen);
+		std::string fen = board.toFen();
+		for (int depth = 1; depth <= 3; ++depth)
+		{
+			uint64_t expected = position.nodes[depth - 1];
+			assert(perft(board, depth) == expected);
+			assert(perftDivide(board, depth, divide) == expected);
+			assert((int)divide.size() == (int)position.nodes[0]);
+			assert(perft(board, depth, &hash) == expected);
+			assert(perftDivide(board, depth, divide, 4, &hash) == expected);
+			// 统计完局面不变
+			assert(board.toFen() == fen);
+		}
+	}
+	assert(perft(board, 0) == 1);
+
+	printf("perft unittest passed\n");
+	return 0;
+}
@@ -0,0 +1,44 @@
+#include "../board.h"
+#include "../search_engine.h"
+#include <assert.h>
+#include <stdio.h>
+
+using namespace ::wsun::cchess::cppupdate;
+
+// 静态搜索第一层的不吃子将军着法：红车吃马之后，黑车不吃子地沉底将军(h9h0)就是杀棋，
+// 另一个黑车封住帅的退路。只搜一层时，这个杀棋只能由静态搜索里的将军着法发现
+static const char* QUIET_MATE_FEN = "4k2r1/n8/9/9/9/R8/9/9/8r/3K5 w";
+
+static Move search(Board& board, SearchEngine& engine, const char* fen, bool checks, int depth)
+{
+	board.resetFromFen(fen);
+	engine.reset();
+	engine.setQuiescenceChecks(checks);
+	return Move(engine.search(1 << 30, depth));
+}
+
+int main()
+{
+	Board board;
+	SearchEngine engine(&board);
+	engine.setVerbose(false);
+	assert(!engine.quiescenceChecks());
+
+	Move capture(iccs_move_to_move("a4a8"));
+	// 不搜索将军着法时看不到吃马之后的杀棋
+	assert(search(board, engine, QUIET_MATE_FEN, false, 1) == capture);
+	// 搜索将军着法时避开吃马
+	assert(search(board, engine, QUIET_MATE_FEN, true, 1) != capture);
+
+	// 确认吃马之后黑方确实一步杀
+	board.resetFromFen(QUIET_MATE_FEN);
+	board.play(capture);
+	engine.reset();
+	engine.setQuiescenceChecks(false);
+	assert(engine.search(1 << 30, 1) == iccs_move_to_move("h9h0"));
+	board.play(Move(iccs_move_to_move("h9h0")));
+	assert(board.noWayToMove());
+
+	printf("quiescence unittest passed\n");
+	return 0;
+}
@@ -0,0 +1,59 @@
+#include "../board.h"
+#include <assert.h>
+#include <stdio.h>
+#include <algorithm>
+
+using namespace ::wsun::cchess::cppupdate;
+
+// 静态交换评估：手工摆出炮架、马腿、帅(将)照面会随兑换变化的局面，
+// 按子力价值表算出期望的得失
+
+// 棋子在ICCS坐标处的子力价值
+static int value(int side, int type, const char* iccs)
+{
+	return Position::pieceValue(side, type, iccs_pos_to_pos(iccs[0], iccs[1]));
+}
+
+static int see(Board& board, const char* fen, const char* iccs)
+{
+	board.resetFromFen(fen);
+	std::string before = board.toFen();
+	int result = board.see(Move(iccs_move_to_move(iccs)));
+	// 只能临时改动局面
+	assert(board.toFen() == before);
+	assert(board.losingCapture(Move(iccs_move_to_move(iccs))) == (result < 0));
+	return result;
+}
+
+int main()
+{
+	Board board;
+	int pawn = value(SIDE_TYPE_BLACK, PIECE_TYPE_PAWN, "e5");
+	int redRook = value(SIDE_TYPE_RED, PIECE_TYPE_ROOK, "e5");
+	int blackRook = value(SIDE_TYPE_BLACK, PIECE_TYPE_ROOK, "e5");
+
+	// 车吃有车保护的卒
+	assert(see(board, "3kr4/9/9/9/4p4/9/4R4/9/9/5K3 w", "e3e5") == pawn - redRook);
+	// 车后面的炮隔着仕可以再吃回来
+	assert(see(board, "3kr4/9/9/9/4p4/9/4R4/9/4A4/4CK3 w", "e3e5") ==
+			std::min(pawn, pawn - redRook + blackRook));
+	// 车走开之后炮没有炮架，不能像国际象棋那样透过去吃
+	assert(see(board, "3kr4/9/9/9/4p4/9/4R4/9/9/4CK3 w", "e3e5") == pawn - redRook);
+	// 炮以车为炮架吃卒，被吃回之后车再吃
+	assert(see(board, "3kr4/9/9/9/4p4/9/4R4/9/9/4CK3 w", "e0e5") ==
+			std::min(pawn, pawn - value(SIDE_TYPE_RED, PIECE_TYPE_CANNON, "e5") + blackRook));
+
+	// 仕从马腿上走开去吃卒，马就能吃回来
+	int deepPawn = value(SIDE_TYPE_BLACK, PIECE_TYPE_PAWN, "e1");
+	int advisor = value(SIDE_TYPE_RED, PIECE_TYPE_ADVISOR, "e1");
+	assert(see(board, "4k4/9/9/9/9/9/3n5/3A5/4p4/3K5 w", "d2e1") == std::min(deepPawn, deepPawn - advisor));
+	assert(see(board, "4k4/9/9/9/9/9/9/3A5/4p4/3K5 w", "d2e1") == deepPawn);
+
+	// 帅吃子之后与将照面，不能吃
+	assert(see(board, "4k4/9/9/9/9/9/9/9/4n4/4K4 w", "e0e1") < 0);
+	assert(see(board, "3k5/9/9/9/9/9/9/9/4n4/4K4 w", "e0e1") ==
+			value(SIDE_TYPE_BLACK, PIECE_TYPE_KNIGHT, "e1"));
+
+	printf("see unittest passed\n");
+	return 0;
+}
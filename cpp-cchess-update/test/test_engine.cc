@@ -8,17 +8,21 @@ int main(int argc, char** argv)
 {
 	if (argc < 2)
 	{
-		printf("%s search-milliseconds\n", argv[0]);
+		printf("%s search-milliseconds [threads] [hash-mb]\n", argv[0]);
 		exit(1);
 	}
 	int searchTime = atoi(argv[1]);
 	std::unique_ptr<Board> b(new Board);
 	std::unique_ptr<SearchEngine> engine(new SearchEngine(b.get()));
+	if (argc > 2)
+		engine->setThreads(atoi(argv[2]));
+	if (argc > 3)
+		engine->setHashSize(atoi(argv[3]));
 	while (!b->noWayToMove())
 	{
 		int mv = engine->search(searchTime);
 		if (mv > 0)
-			b->play(mv);
+			b->play(Move(mv));
 		else
 			break;
 	}
@@ -0,0 +1,67 @@
+#include "../transposition_table.h"
+#include <assert.h>
+#include <stdio.h>
+
+using namespace ::wsun::cchess::cppupdate;
+
+// 置换表的读写、同一局面的覆盖规则以及桶满之后的替换顺序
+
+// index相同(落在同一个桶)、校验值不同的局面
+static Zobrist make_zobrist(uint32_t index, uint32_t check)
+{
+	Zobrist zobrist;
+	zobrist.key_ = index | ((uint64_t)check << 32);
+	zobrist.lock_ = ~check;
+	return zobrist;
+}
+
+static TTData make_data(int depth, int value)
+{
+	TTData data;
+	data.mv = Move(0x3355);
+	data.value = (int16_t)value;
+	data.depth = (uint8_t)depth;
+	data.flag = 2;
+	data.generation = 0;
+	return data;
+}
+
+int main()
+{
+	TranspositionTable table;
+	table.resize(1);
+	assert(table.megabytes() == 1);
+	table.newSearch();
+
+	TTData data;
+	Zobrist a = make_zobrist(7, 1);
+	assert(!table.probe(a, &data));
+	table.store(a, make_data(5, -9990));
+	assert(table.probe(a, &data));
+	assert(data.mv == Move(0x3355) && data.value == -9990 && data.depth == 5 && data.flag == 2);
+	assert(data.generation == table.generation());
+
+	// 本次搜索写入的更深的结果不被更浅的覆盖，下一次搜索可以覆盖
+	table.store(a, make_data(3, 10));
+	assert(table.probe(a, &data) && data.depth == 5);
+	table.newSearch();
+	table.store(a, make_data(3, 10));
+	assert(table.probe(a, &data) && data.depth == 3 && data.value == 10);
+
+	// 桶满之后先替换旧一代的条目，再替换最浅的条目
+	table.clear();
+	table.store(make_zobrist(7, 2), make_data(9, 0));
+	table.newSearch();
+	for (uint32_t check = 3; check < 6; ++check)
+		table.store(make_zobrist(7, check), make_data(check, 0));
+	table.store(make_zobrist(7, 6), make_data(1, 0));
+	assert(!table.probe(make_zobrist(7, 2), &data));
+	table.store(make_zobrist(7, 7), make_data(8, 0));
+	assert(!table.probe(make_zobrist(7, 6), &data));
+	for (uint32_t check = 3; check < 6; ++check)
+		assert(table.probe(make_zobrist(7, check), &data) && data.depth == check);
+	assert(table.probe(make_zobrist(7, 7), &data));
+
+	printf("transposition table unittest passed\n");
+	return 0;
+}
@@ -0,0 +1,118 @@
+#include "transposition_table.h"
+#include <new>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+namespace wsun
+{
+namespace cchess
+{
+namespace cppupdate
+{
+
+// 透明大页的大小，置换表按它对齐
+static const size_t HUGE_PAGE_SIZE = 2ul << 20;
+
+TranspositionTable::~TranspositionTable()
+{
+	free(buckets_);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+	free(buckets_);
+	buckets_ = nullptr;
+	bucketCount_ = 0;
+
+	size_t count = 1;
+	while (count * 2 * sizeof(Bucket) <= (megabytes << 20))
+		count <<= 1;
+
+	// 分配失败就减半，至少保留一个桶
+	void* memory = nullptr;
+	size_t bytes = 0;
+	for (; count > 0; count >>= 1)
+	{
+		bytes = count * sizeof(Bucket);
+		size_t alignment = bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : sizeof(Bucket);
+		if (posix_memalign(&memory, alignment, bytes) == 0)
+			break;
+		memory = nullptr;
+	}
+	if (!memory)
+		return;
+
+#ifdef MADV_HUGEPAGE
+	if (bytes >= HUGE_PAGE_SIZE)
+		madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+
+	buckets_ = static_cast<Bucket*>(memory);
+	bucketCount_ = count;
+	for (size_t i = 0; i < bucketCount_; ++i)
+		new (&buckets_[i]) Bucket();
+}
+
+void TranspositionTable::clear()
+{
+	for (size_t i = 0; i < bucketCount_; ++i)
+	{
+		for (Entry& entry : buckets_[i].entries)
+		{
+			entry.check.store(0, std::memory_order_relaxed);
+			entry.data.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+bool TranspositionTable::probe(const Zobrist& zobrist, TTData* data) const
+{
+	uint64_t key = checksum(zobrist);
+	for (const Entry& entry : bucket(zobrist)->entries)
+	{
+		uint64_t bits = entry.data.load(std::memory_order_relaxed);
+		if ((entry.check.load(std::memory_order_relaxed) ^ bits) == key)
+		{
+			*data = unpack(bits);
+			return true;
+		}
+	}
+	return false;
+}
+
+void TranspositionTable::store(const Zobrist& zobrist, const TTData& data)
+{
+	uint64_t key = checksum(zobrist);
+	Entry* victim = nullptr;
+	int victimScore = 0;
+	for (Entry& entry : bucket(zobrist)->entries)
+	{
+		uint64_t bits = entry.data.load(std::memory_order_relaxed);
+		TTData old = unpack(bits);
+		if ((entry.check.load(std::memory_order_relaxed) ^ bits) == key)
+		{
+			if (old.generation == generation_ && old.depth > data.depth)
+				return;
+			victim = &entry;
+			break;
+		}
+
+		// 每旧一代相当于浅8层
+		int score = old.depth - 8 * (uint8_t)(generation_ - old.generation);
+		if (!victim || score < victimScore)
+		{
+			victim = &entry;
+			victimScore = score;
+		}
+	}
+
+	TTData stored = data;
+	stored.generation = generation_;
+	uint64_t bits = pack(stored);
+	victim->check.store(key ^ bits, std::memory_order_relaxed);
+	victim->data.store(bits, std::memory_order_relaxed);
+}
+
+} // namespace cppupdate
+} // namespace cchess
+} // namespace wsun
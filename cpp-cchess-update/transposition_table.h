@@ -0,0 +1,110 @@
+#ifndef __WSUN_CCHESS_CPP_UPDATE_TRANSPOSITION_TABLE_H__
+#define __WSUN_CCHESS_CPP_UPDATE_TRANSPOSITION_TABLE_H__
+
+#include "utils.h"
+#include "zobrist_helper.h"
+#include <atomic>
+#include <inttypes.h>
+#include <stddef.h>
+
+namespace wsun
+{
+namespace cchess
+{
+namespace cppupdate
+{
+
+// 默认的置换表大小(MB)
+static const size_t DEFAULT_HASH_MB = 16;
+
+// 置换表条目的内容，读写时打包成64位
+struct TTData
+{
+	Move mv;
+	int16_t value;
+	uint8_t depth;
+	uint8_t flag;				// alpha、beta、pv 三种节点类型
+	uint8_t generation;	// 写入时的搜索代数
+};
+
+// 置换表：每4个条目组成一个64字节的桶，一个桶正好占一条缓存行。
+// 条目保存打包后的数据以及校验值与数据的异或，读写都不加锁，
+// 读到被其他线程写了一半的条目时校验不通过，当作没有命中
+class TranspositionTable
+{
+public:
+	TranspositionTable() {}
+	~TranspositionTable();
+
+	TranspositionTable(const TranspositionTable&) = delete;
+	TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+	// 按megabytes重新分配(桶数取2的幂)并清空，大于2MB时建议内核使用大页
+	void resize(size_t megabytes);
+	size_t megabytes() const { return (bucketCount_ * sizeof(Bucket)) >> 20; }
+	void clear();
+
+	// 开始新的一次搜索，之前写入的条目在替换时优先被淘汰
+	void newSearch() { ++generation_; }
+	uint8_t generation() const { return generation_; }
+
+	bool probe(const Zobrist& zobrist, TTData* data) const;
+	// 同一局面的条目直接覆盖(除非旧条目是本次搜索写入的并且更深)，
+	// 否则替换桶中深度最浅、代数最旧的条目
+	void store(const Zobrist& zobrist, const TTData& data);
+
+private:
+	static const int BUCKET_ENTRIES = 4;
+
+	struct Entry
+	{
+		std::atomic<uint64_t> check;	// 校验值与data的异或
+		std::atomic<uint64_t> data;
+	};
+
+	struct alignas(64) Bucket
+	{
+		Entry entries[BUCKET_ENTRIES];
+	};
+
+	// 索引之外的64位校验值：zobrist key的高32位加上lock
+	static uint64_t checksum(const Zobrist& zobrist)
+	{
+		return zobrist.check() | ((uint64_t)zobrist.lock_ << 32);
+	}
+
+	static uint64_t pack(const TTData& data)
+	{
+		return (uint64_t)data.mv.value() |
+			((uint64_t)(uint16_t)data.value << 16) |
+			((uint64_t)data.depth << 32) |
+			((uint64_t)data.flag << 40) |
+			((uint64_t)data.generation << 48);
+	}
+
+	static TTData unpack(uint64_t bits)
+	{
+		TTData data;
+		data.mv = Move((uint16_t)bits);
+		data.value = (int16_t)(uint16_t)(bits >> 16);
+		data.depth = (uint8_t)(bits >> 32);
+		data.flag = (uint8_t)(bits >> 40);
+		data.generation = (uint8_t)(bits >> 48);
+		return data;
+	}
+
+	Bucket* bucket(const Zobrist& zobrist) const
+	{
+		return &buckets_[zobrist.index() & (bucketCount_ - 1)];
+	}
+
+	Bucket* buckets_ = nullptr;
+	size_t bucketCount_ = 0;
+	uint8_t generation_ = 0;
+};
+
+} // namespace cppupdate
+} // namespace cchess
+} // namespace wsun
+
+#endif // __WSUN_CCHESS_CPP_UPDATE_TRANSPOSITION_TABLE_H__
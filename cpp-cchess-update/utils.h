@@ -4,6 +4,7 @@
 #include "constants.h"
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
 
 namespace wsun
 {
@@ -90,11 +91,36 @@ inline static int end_of_move(int mv)
 	return (mv >> 8);
 }
 
-inline static int get_move(int start, int end)
+inline static constexpr int get_move(int start, int end)
 {
 	return (start | (end << 8));
 }
 
+// 16位走法：低8位为起点，高8位为终点，与get_move生成的int走法编码相同，0表示没有走法
+// 默认构造不做初始化，避免走法列表每次构造都清零整个数组，需要空走法时用Move()
+class Move
+{
+public:
+	Move() = default;
+	constexpr Move(int start, int end) : mv_((uint16_t)get_move(start, end)) {}
+	// 从int编码的走法转换
+	constexpr explicit Move(int mv) : mv_((uint16_t)mv) {}
+
+	constexpr int start() const { return mv_ & 0xff; }
+	constexpr int end() const { return mv_ >> 8; }
+	// int编码的走法，也用作历史表下标
+	constexpr int value() const { return mv_; }
+
+	constexpr explicit operator bool() const { return mv_ != 0; }
+	constexpr bool operator==(Move rhs) const { return mv_ == rhs.mv_; }
+	constexpr bool operator!=(Move rhs) const { return mv_ != rhs.mv_; }
+
+private:
+	uint16_t mv_;
+};
+
+static_assert(sizeof(Move) == 2, "Move must be 16 bits");
+
 inline static int convert_reserse_move(int mv)
 {
 	return get_move(end_of_move(mv), start_of_move(mv));
@@ -0,0 +1,14 @@
+#include "zobrist_helper.h"
+
+namespace wsun
+{
+namespace cchess
+{
+namespace cppupdate
+{
+
+constexpr ZobristTable zobrist_table;
+
+} // namespace cppupdate
+} // namespace cchess
+} // namespace wsun
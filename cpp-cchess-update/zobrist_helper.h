@@ -3,7 +3,6 @@
 
 #include "utils.h"
 #include <inttypes.h>
-#include <array>
 
 namespace wsun
 {
@@ -12,77 +11,95 @@ namespace cchess
 namespace cppupdate
 {
 
-// RC4密码流
+// RC4密码流，可以在编译期使用
 class RC4
 {
 public:
-	RC4() : x_(0), y_(0)
+	constexpr RC4() : x_(0), y_(0), state_()
 	{
-		int i = 0;
-		int j = 0;
-		for (i = 0; i < state_.size(); ++i)
+		for (int i = 0; i < 256; ++i)
 		{
-			state_[i] = i;
+			state_[i] = (uint8_t)i;
 		}
-		for (i = 0; i < state_.size(); ++i)
+		int j = 0;
+		for (int i = 0; i < 256; ++i)
 		{
 			j = (j + state_[i]) & 0xff;
-			std::swap(state_[i], state_[j]);
+			swapState(i, j);
 		}
 	}
 
-	uint8_t nextByte()
+	constexpr uint8_t nextByte()
 	{
 		x_ = (x_ + 1) & 0xff;
 		y_ = (y_ + state_[x_]) & 0xff;
-		std::swap(state_[x_], state_[y_]);
+		swapState(x_, y_);
 		return state_[(state_[x_] + state_[y_]) & 0xff];
 	}
 
-	uint32_t nextLong()
+	// 按低字节在前的顺序取4个字节
+	constexpr uint32_t nextLong()
 	{
-		return nextByte() + (nextByte() << 8) + (nextByte() << 16) + (nextByte() << 24);
+		uint32_t b0 = nextByte();
+		uint32_t b1 = nextByte();
+		uint32_t b2 = nextByte();
+		uint32_t b3 = nextByte();
+		return b0 | (b1 << 8) | (b2 << 16) | (b3 << 24);
 	}
 
 private:
+	constexpr void swapState(int i, int j)
+	{
+		uint8_t t = state_[i];
+		state_[i] = state_[j];
+		state_[j] = t;
+	}
+
 	int x_;
 	int y_;
-	std::array<uint8_t, 256> state_;
+	uint8_t state_[256];
 };
 
+// 64位key加32位lock，依次取自RC4密码流的key、lock1、lock2
 struct Zobrist
 {
-	Zobrist() : key_(0), lock1_(0), lock2_(0)
+	constexpr Zobrist() : key_(0), lock_(0)
 	{
 	}
 
-	Zobrist(RC4& rc4)
+	constexpr Zobrist(RC4& rc4) : key_(0), lock_(0)
 	{
-		key_ = rc4.nextLong();
-		lock1_ = rc4.nextLong();
-		lock2_ = rc4.nextLong();
+		uint64_t key = rc4.nextLong();
+		uint64_t lock1 = rc4.nextLong();
+		key_ = key | (lock1 << 32);
+		lock_ = rc4.nextLong();
 	}
 
 	void reset()
 	{
-		key_ = lock1_ = lock2_ = 0;
+		key_ = 0;
+		lock_ = 0;
 	}
 
 	void zXOR(const Zobrist& rhs)
 	{
 		key_ ^= rhs.key_;
-		lock1_ ^= rhs.lock1_;
-		lock2_ ^= rhs.lock2_;
+		lock_ ^= rhs.lock_;
 	}
 
-	uint32_t key_;
-	uint32_t lock1_;
-	uint32_t lock2_;
+	// 低32位用作置换表索引，高32位用作置换表校验
+	uint32_t index() const { return (uint32_t)key_; }
+	uint32_t check() const { return (uint32_t)(key_ >> 32); }
+
+	uint64_t key_;
+	uint32_t lock_;		// 开局库(BOOK.DAT)使用的校验值
 };
 
-class ZobristHelper {
+// 所有棋盘共用的zobrist表，编译期生成
+class ZobristTable
+{
 public:
-	ZobristHelper()
+	constexpr ZobristTable() : zobristPlayer_(), pieceZoristTable_()
 	{
 		RC4 rc4;
 		zobristPlayer_ = Zobrist(rc4);
@@ -98,9 +115,28 @@ public:
 		}
 	}
 
+	const Zobrist& player() const { return zobristPlayer_; }
+	const Zobrist& piece(int side, int type, int pos) const
+	{
+		return pieceZoristTable_[side][type][pos];
+	}
+
+private:
+	// 用来标志下棋方的一个zobrist值
+	Zobrist zobristPlayer_;
+	// 每种棋子在每种位置所对应的一个zobrist值
+	Zobrist pieceZoristTable_[2][7][256];	
+};
+
+extern const ZobristTable zobrist_table;
+
+// 只保存当前局面的zobrist值，可以直接按值拷贝
+class ZobristHelper {
+public:
 	void reset() 
 	{
 		zobrist_ = Zobrist();
+		mirrorZobrist_ = Zobrist();
 	}
 
 	const Zobrist& getZobrist() const
@@ -108,23 +144,35 @@ public:
 		return zobrist_;
 	}
 
+	// 左右镜像局面的zobrist值，与当前局面同步更新
+	const Zobrist& getMirrorZobrist() const
+	{
+		return mirrorZobrist_;
+	}
+
+	// 直接恢复为之前保存的值
+	void setZobrist(const Zobrist& zobrist, const Zobrist& mirrorZobrist)
+	{
+		zobrist_ = zobrist;
+		mirrorZobrist_ = mirrorZobrist;
+	}
+
 	void updateByChangeSide()
 	{
-		zobrist_.zXOR(zobristPlayer_);
+		zobrist_.zXOR(zobrist_table.player());
+		mirrorZobrist_.zXOR(zobrist_table.player());
 	}
 
 	void updateByChangePiece(int side, int type, int pos)
 	{
-		zobrist_.zXOR(pieceZoristTable_[side][type][pos]);
+		zobrist_.zXOR(zobrist_table.piece(side, type, pos));
+		mirrorZobrist_.zXOR(zobrist_table.piece(side, type, mirror_pos(pos)));
 	}
 
 private:
 	// 对应当前局面的一个值，用来区分每一个不同的局面
 	Zobrist zobrist_;				
-	// 用来标志下棋方的一个zobrist值
-	Zobrist zobristPlayer_;
-	// 每种棋子在每种位置所对应的一个zobrist值
-	Zobrist pieceZoristTable_[2][7][256];	
+	Zobrist mirrorZobrist_;
 };
 
 } // namespace cppupdate
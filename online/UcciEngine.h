@@ -37,10 +37,11 @@ public:
 		send(command);
 	}
 
-	std::string search(const std::string& fen, int milliseconds)
+	// position: "fen <fen串> [moves <着法> ...]"或"startpos ..."，原样作为position命令的参数
+	std::string search(const std::string& position, int milliseconds)
 	{
 		std::string iccs_mv;
-		std::string s = "position fen " + fen + "\n";
+		std::string s = "position " + position + "\n";
 		send(s);
 		char movestr[BUFSIZ] = {'\0'};
 		snprintf(movestr, BUFSIZ, "%s %d\n", moveCommand_.c_str(), milliseconds);
@@ -32,7 +32,8 @@ struct EnginePlayer
   EnginePlayer(int side, int stepSearchTime)
     : side(side), stepSearchTime(stepSearchTime) {}
 
-  virtual const std::string search(const std::string& fen) = 0;
+  // position: "fen <起始局面> [moves <着法> ...]"，引擎据此增量同步局面后搜索
+  virtual const std::string search(const std::string& position) = 0;
   virtual const std::string getFen()
   {
     return "";
@@ -54,9 +55,9 @@ struct CEnginePlayer : EnginePlayer
     board_release(board);
   }
 
-  const std::string search(const std::string& fen)
+  const std::string search(const std::string& position)
   {
-    board_reset_from_fen(board, fen.c_str());
+    syncPosition(position);
     int mv = ::search(engine, stepSearchTime);
     if (mv == 0) return "";
     char iccs_mv[5] = {0};
@@ -70,6 +71,27 @@ struct CEnginePlayer : EnginePlayer
     board_to_fen(board, fen);
     return fen;
   }
+
+  // 上次同步的position是这次的前缀时只走新增的着法，否则从fen串重置后走完所有着法
+  void syncPosition(const std::string& position)
+  {
+    size_t from = synced.size();
+    if (synced.empty() || position.compare(0, synced.size(), synced) != 0)
+    {
+      auto movesPos = position.find(" moves");
+      board_reset_from_fen(board, position.substr(4, movesPos - 4).c_str());
+      from = movesPos == std::string::npos ? position.size() : movesPos;
+    }
+    if (position.compare(from, 6, " moves") == 0)
+      from += 6;
+    for (; from + 5 <= position.size(); from += 5)
+    {
+      board_play_iccs(board, position.c_str() + from + 1);
+    }
+    synced = position;
+  }
+
+  std::string synced;
 };
 
 using wsun::cchess::cppupdate::Board;
@@ -86,9 +108,9 @@ struct CCEnginePlayer : EnginePlayer
   {
   }
 
-  const std::string search(const std::string& fen)
+  const std::string search(const std::string& position)
   {
-    board->resetFromFen(fen.c_str());
+    engine->syncPosition(position.c_str());
     int mv = engine->search(stepSearchTime);
     if (mv == 0) return "";
     char iccs_mv[5] = {0};
@@ -111,9 +133,9 @@ struct StockfishEnginePlayer : EnginePlayer
   {
   }
 
-  const std::string search(const std::string& fen)
+  const std::string search(const std::string& position)
   {
-    return engine->search(fen, stepSearchTime);
+    return engine->search(position, stepSearchTime);
   }
 };
 
@@ -126,9 +148,9 @@ struct EleeyeEnginePlayer : EnginePlayer
   {
   }
 
-  const std::string search(const std::string& fen)
+  const std::string search(const std::string& position)
   {
-    return engine->search(fen, stepSearchTime);
+    return engine->search(position, stepSearchTime);
   }
 };
 
@@ -137,10 +159,15 @@ struct MatchContext
   std::unique_ptr<Board> board;
   std::unique_ptr<EnginePlayer> engines[2];
   int side;
+  // 起始局面加上已走的着法，每步只追加一个着法，引擎不需要每次都从头解析
+  std::string position;
+  int plies;
 
   MatchContext()
   {
     board.reset(new Board);
+    position = "fen " + board->toFen();
+    plies = 0;
     initEngine();
   }
 
@@ -153,10 +180,10 @@ struct MatchContext
 
   std::string play()
   {
-    auto curFen = board->toFen();
-    auto iccsMv = engines[side]->search(curFen);
+    auto iccsMv = engines[side]->search(position);
     if (iccsMv.empty()) return iccsMv;
     board->play(iccsMv.c_str());
+    position += (plies++ == 0 ? " moves " : " ") + iccsMv;
     side = 1 - side;
     return iccsMv;
   }